@@ -0,0 +1,321 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/*
+ * Micro-Benchmarks für ppltk
+ *
+ * Läuft ohne Videogerät auf dem WindowManager_Headless und gibt die Ergebnisse
+ * als JSON auf stdout aus. Alle Testdaten werden deterministisch erzeugt, damit
+ * die Zahlen zwischen zwei Versionen vergleichbar sind.
+ *
+ * Aufruf: ppltk-bench [Filter]
+ * Ist ein Filter angegeben, laufen nur Benchmarks, deren Name ihn enthält.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <list>
+#include <string>
+#include <ppl7.h>
+#include <ppl7-grafix.h>
+#include "ppltk.h"
+
+class BenchResult
+{
+public:
+    ppl7::String name;
+    size_t size;
+    int iterations;
+    double mean_us;
+    double min_us;
+    double max_us;
+};
+
+static std::list<BenchResult> results;
+static const char* filter = NULL;
+
+template<typename Func> static void run(const ppl7::String& name, size_t size, int iterations, Func func)
+{
+    if (filter != NULL && strstr((const char*)name, filter) == NULL) return;
+    func();	// Aufwärmen
+    BenchResult r;
+    r.name = name;
+    r.size = size;
+    r.iterations = iterations;
+    r.min_us = 0.0;
+    r.max_us = 0.0;
+    double total = 0.0;
+    for (int i = 0;i < iterations;i++) {
+        double start = ppl7::GetMicrotime();
+        func();
+        double us = (ppl7::GetMicrotime() - start) * 1000000.0;
+        total += us;
+        if (i == 0 || us < r.min_us) r.min_us = us;
+        if (us > r.max_us) r.max_us = us;
+    }
+    r.mean_us = total / (double)iterations;
+    results.push_back(r);
+    fprintf(stderr, "%-40s %8zu %12.2f us\n", (const char*)name, size, r.mean_us);
+}
+
+static void printResults()
+{
+    printf("{\n  \"library\": \"ppltk\",\n  \"benchmarks\": [\n");
+    std::list<BenchResult>::const_iterator it;
+    for (it = results.begin();it != results.end();++it) {
+        if (it != results.begin()) printf(",\n");
+        printf("    {\"name\": \"%s\", \"size\": %zu, \"iterations\": %d, \"mean_us\": %.3f, \"min_us\": %.3f, \"max_us\": %.3f}",
+            (const char*)(*it).name, (*it).size, (*it).iterations, (*it).mean_us, (*it).min_us, (*it).max_us);
+    }
+    printf("\n  ]\n}\n");
+}
+
+/*
+ * Einfacher linearer Kongruenzgenerator, damit die Testdaten auf allen Plattformen
+ * gleich sind
+ */
+static uint32_t random_state = 12345;
+static uint32_t nextRandom()
+{
+    random_state = random_state * 1103515245 + 12345;
+    return (random_state >> 16) & 0x7fff;
+}
+
+/*
+ * Erzeugt einen Baum aus insgesamt count Widgets mit bis zu fanout Kindern pro
+ * Ebene. Frames bekommen weitere Kinder, Labels sind Blätter.
+ */
+static ppltk::Widget* buildTree(ppltk::Widget* root, int count, int fanout)
+{
+    std::list<ppltk::Widget*> parents;
+    parents.push_back(root);
+    ppltk::Widget* last = root;
+    int created = 0;
+    while (created < count && parents.size() > 0) {
+        ppltk::Widget* parent = parents.front();
+        parents.pop_front();
+        ppl7::grafix::Size s = parent->clientSize();
+        int cols = 1;
+        while (cols * cols < fanout) cols++;
+        int cw = s.width / cols;
+        int ch = s.height / cols;
+        if (cw < 4) cw = 4;
+        if (ch < 4) ch = 4;
+        for (int i = 0;i < fanout && created < count;i++) {
+            int x = (i % cols) * cw;
+            int y = (i / cols) * ch;
+            ppltk::Widget* w;
+            if (i % 2 == 0) {
+                w = new ppltk::Frame(x, y, cw, ch);
+                parents.push_back(w);
+            } else {
+                w = new ppltk::Label(x, y, cw, ch, ppl7::ToString("Label %d", created));
+            }
+            parent->addChild(w);
+            last = w;
+            created++;
+        }
+    }
+    return last;
+}
+
+static void benchDraw(ppltk::WindowManager_Headless& wm)
+{
+    const int sizes[] = { 10, 1000, 10000 };
+    for (int i = 0;i < 3;i++) {
+        ppltk::Window win;
+        win.setWindowSize(1280, 720);
+        wm.createWindow(win);
+        ppltk::Widget* leaf = buildTree(&win, sizes[i], 10);
+        win.drawWidgets();
+        int iterations = sizes[i] > 1000 ? 20 : 200;
+        run("Widget::draw/full", sizes[i], iterations, [&]() {
+            win.needsRedraw();
+            win.drawWidgets();
+            });
+        run("Widget::draw/single_leaf", sizes[i], iterations * 10, [&]() {
+            leaf->needsRedraw();
+            win.drawWidgets();
+            });
+        win.destroyChilds();
+        wm.destroyWindow(win);
+    }
+}
+
+static void benchFindMouseWidget(ppltk::WindowManager_Headless& wm)
+{
+    const int sizes[] = { 10, 100, 1000 };
+    for (int i = 0;i < 3;i++) {
+        ppltk::Window win;
+        win.setWindowSize(1280, 720);
+        wm.createWindow(win);
+        ppltk::Widget* parent = &win;
+        for (int d = 0;d < sizes[i];d++) {
+            ppltk::Widget* w = new ppltk::Widget(0, 0, 1280, 720);
+            parent->addChild(w);
+            parent = w;
+        }
+        run("WindowManager::findMouseWidget/deep", sizes[i], 10000, [&]() {
+            ppl7::grafix::Point p(640, 360);
+            wm.findMouseWidget(&win, p);
+            });
+        win.destroyChilds();
+        wm.destroyWindow(win);
+    }
+    const int wide[] = { 10, 1000, 10000 };
+    for (int i = 0;i < 3;i++) {
+        ppltk::Window win;
+        win.setWindowSize(1280, 720);
+        wm.createWindow(win);
+        for (int c = 0;c < wide[i];c++) {
+            win.addChild(new ppltk::Widget((c % 128) * 10, (c / 128) * 9, 10, 9));
+        }
+        run("WindowManager::findMouseWidget/wide", wide[i], 10000, [&]() {
+            ppl7::grafix::Point p(5, 5);
+            wm.findMouseWidget(&win, p);
+            });
+        win.destroyChilds();
+        wm.destroyWindow(win);
+    }
+}
+
+static ppl7::String makeText(size_t size)
+{
+    std::string text;
+    text.reserve(size + 16);
+    random_state = 12345;
+    while (text.size() < size) {
+        int len = 1 + nextRandom() % 10;
+        for (int i = 0;i < len;i++) text.push_back((char)('a' + nextRandom() % 26));
+        if (nextRandom() % 12 == 0) text.push_back('\n');
+        else text.push_back(' ');
+    }
+    text.resize(size);
+    return ppl7::String(text.c_str());
+}
+
+static void benchTextEdit(ppltk::WindowManager_Headless& wm)
+{
+    const size_t sizes[] = { 1024, 10 * 1024, 100 * 1024, 1024 * 1024, 10 * 1024 * 1024 };
+    for (int i = 0;i < 5;i++) {
+        ppltk::TextEdit edit(0, 0, 600, 400);
+        edit.setText(makeText(sizes[i]));
+        ppl7::grafix::Image img[2];
+        img[0].create(600, 400, ppl7::grafix::RGBFormat::A8R8G8B8);
+        img[1].create(601, 400, ppl7::grafix::RGBFormat::A8R8G8B8);
+        int n = 0;
+        int iterations = sizes[i] >= 1024 * 1024 ? 3 : 20;
+        // Die Breite wechselt bei jedem Durchlauf, damit der Cache neu aufgebaut wird
+        run("TextEdit::rebuildCache", sizes[i], iterations, [&]() {
+            edit.paint(img[n & 1]);
+            n++;
+            });
+        // Tippen am Textanfang, der Umbruch bleibt gültig
+        edit.paint(img[0]);
+        ppltk::TextInputEvent ev;
+        ev.text.set(L"x");
+        run("TextEdit::type", sizes[i], 1000, [&]() {
+            edit.textInputEvent(&ev);
+            });
+    }
+}
+
+static void benchListWidget(ppltk::WindowManager_Headless& wm)
+{
+    const int count = 100000;
+    run("ListWidget::add", count, 3, [&]() {
+        ppltk::ListWidget list(0, 0, 300, 600);
+        for (int i = 0;i < count;i++) list.add(ppl7::ToString("Item %d", i), ppl7::ToString("%d", i));
+        });
+    ppltk::ListWidget list(0, 0, 300, 600);
+    for (int i = 0;i < count;i++) list.add(ppl7::ToString("Item %d", i), ppl7::ToString("%d", i));
+    ppl7::grafix::Image img;
+    img.create(300, 600, ppl7::grafix::RGBFormat::A8R8G8B8);
+    run("ListWidget::paint", count, 100, [&]() {
+        list.paint(img);
+        });
+    // Scrollen über die Scrollbar der Liste, abwechselnd nach unten und oben
+    ppltk::Scrollbar* bar = NULL;
+    for (auto it = list.childsBegin();it != list.childsEnd() && !bar;++it) bar = dynamic_cast<ppltk::Scrollbar*>(*it);
+    const int step = count / 50;
+    int pos = 0, direction = step;
+    run("ListWidget::paint/scrolled", count, 100, [&]() {
+        if (pos + direction < 0 || pos + direction >= count) direction = -direction;
+        pos += direction;
+        if (bar) bar->setPosition(pos);
+        list.paint(img);
+        });
+}
+
+static void benchComboBox(ppltk::WindowManager_Headless& wm)
+{
+    const int sizes[] = { 10, 1000, 10000 };
+    for (int i = 0;i < 3;i++) {
+        ppltk::Window win;
+        win.setWindowSize(1280, 720);
+        wm.createWindow(win);
+        ppltk::ComboBox* combo = new ppltk::ComboBox(10, 10, 200, 30);
+        for (int c = 0;c < sizes[i];c++) combo->add(ppl7::ToString("Entry %d", c), ppl7::ToString("%d", c));
+        win.addChild(combo);
+        win.drawWidgets();
+        // Erster Klick öffnet das Popup, der zweite schließt es wieder
+        run("ComboBox::popup", sizes[i], sizes[i] > 1000 ? 10 : 100, [&]() {
+            wm.sendMouseDown(win, 20, 20);
+            wm.sendMouseUp(win, 20, 20);
+            win.drawWidgets();
+            wm.sendMouseDown(win, 20, 20);
+            wm.sendMouseUp(win, 20, 20);
+            wm.advanceTime(wm.getDoubleClickIntervall());
+            });
+        win.destroyChilds();
+        wm.destroyWindow(win);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) filter = argv[1];
+    try {
+        ppl7::grafix::Grafix gfx;
+        ppltk::WindowManager_Headless wm;
+        benchDraw(wm);
+        benchFindMouseWidget(wm);
+        benchTextEdit(wm);
+        benchListWidget(wm);
+        benchComboBox(wm);
+    }
+    catch (ppl7::Exception& e) {
+        e.print();
+        return 1;
+    }
+    printResults();
+    return 0;
+}
@@ -34,22 +34,6 @@
 #include "ppltk.h"
 #include "ppltk-layout.h"
 
-class FrameRate
-{
-private:
-    int desiredFrameRate;
-    int fps;
-    int framecount;
-    ppl7::ppl_time_t lastFpsTime;
-
-public:
-    FrameRate();
-    void setFrameRate(int fps);
-    int getFrameCount() const;
-    int getFPS() const;
-    void updateFPS();
-};
-
 class MainWindow : public ppltk::Window
 {
 private:
@@ -69,18 +53,18 @@ private:
 
     ppltk::LineInput* input;
 
-    FrameRate fps;
+    int fpsTimer;
 
     virtual void closeEvent(ppltk::Event* event);
     virtual void mouseClickEvent(ppltk::MouseEvent* event);
     virtual void resizeEvent(ppltk::ResizeEvent* event);
+    virtual void timerEvent(ppltk::Event* event);
 
 public:
     MainWindow();
     ~MainWindow();
 
     void create(int width, int height, bool fullscreen);
-    void updateFrameRate();
 
 
 };
@@ -60,15 +60,7 @@ int start(int agrc, char** argv)
 
 
         //SDL_Renderer *renderer=(SDL_Renderer*)win.getRenderer();
-        while (wm.numWindows() > 0) {
-            win.updateFrameRate();
-            win.clearScreen();
-            win.drawWidgets();
-            win.presentScreen();
-
-            wm.handleEvents();
-
-        }
+        wm.startEventLoop();
     }
     catch (ppl7::Exception& e) {
         e.print();
@@ -98,6 +90,7 @@ MainWindow::MainWindow()
     text = NULL;
     smalltext = NULL;
     input = NULL;
+    fpsTimer = 0;
     Style.setStyle(ppltk::WidgetStyle::Dark);
     //Style.labelFont.setSize(20);
     wm = ppltk::GetWindowManager();
@@ -193,11 +186,14 @@ void MainWindow::create(int width, int height, bool fullscreen)
     exitButton->setEventHandler(this);
     layout_menue->addWidget(exitButton);
 
+    fpsTimer = wm->startTimer(this, 1000);
+
 }
 
 void MainWindow::closeEvent(ppltk::Event* event)
 {
     ppltk::WindowManager* wm = ppltk::GetWindowManager();
+    wm->removeTimer(fpsTimer);
     wm->destroyWindow(*this);
     event->accept();
 }
@@ -207,6 +203,7 @@ void MainWindow::mouseClickEvent(ppltk::MouseEvent* event)
     Widget* w = event->widget();
     if (w == exitButton) {
         ppltk::WindowManager* wm = ppltk::GetWindowManager();
+        wm->removeTimer(fpsTimer);
         wm->destroyWindow(*this);
         event->accept();
     }
@@ -226,44 +223,9 @@ void MainWindow::resizeEvent(ppltk::ResizeEvent* event)
 }
 
 
-void MainWindow::updateFrameRate()
+void MainWindow::timerEvent(ppltk::Event* event)
 {
-    fps.updateFPS();
-    fpsLabel->setText(ppl7::ToString("%d", fps.getFPS()));
-}
-
-
-
-FrameRate::FrameRate()
-{
-    desiredFrameRate = 0;
-    fps = 0;
-    lastFpsTime = ppl7::GetTime();
-    framecount = 0;
-}
-
-
-void FrameRate::setFrameRate(int fps)
-{
-    desiredFrameRate = fps;
-}
-
-
-
-int FrameRate::getFPS() const
-{
-    return fps;
-}
-
-void FrameRate::updateFPS()
-{
-    framecount++;
-    ppl7::ppl_time_t now = ppl7::GetTime();
-    if (now > lastFpsTime) {
-        lastFpsTime = now;
-        fps = framecount;
-        framecount = 0;
-    }
+    fpsLabel->setText(ppl7::ToString("%d", frameStatistics().fps));
 }
 
 
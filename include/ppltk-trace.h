@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+#ifndef _PPLTK_TRACE_INCLUDE
+#define _PPLTK_TRACE_INCLUDE
+
+/*
+ * Tracing von Zeitabschnitten im Chrome-Trace-Format
+ *
+ * Die Funktionen sind immer in der Bibliothek enthalten, so dass eine Anwendung das
+ * Tracing auch in einem Produktions-Build zur Laufzeit einschalten kann, z.B. wenn ein
+ * Kunde ein ruckelndes UI meldet. Aufgezeichnet wird erst nach
+ * ppltk::trace::setEnabled(true). Solange das Tracing aus ist, kostet eine Zone nur
+ * das Lesen eines Flags. Wird PPLTK_NO_TRACING definiert, z.B. mit
+ * "make EXTRA_CFLAGS=-DPPLTK_NO_TRACING", sind die Makros leer und die Zonen entfallen
+ * ganz. Die Funktionen bleiben auch dann erhalten, es wird nur nichts aufgezeichnet.
+ *
+ * Jeder Thread schreibt in seinen eigenen Ringpuffer, das Aufzeichnen kommt daher ohne
+ * Locks aus. Das Ergebnis kann mit ppltk::trace::writeChromeTrace als JSON gespeichert
+ * und in chrome://tracing oder Perfetto geladen werden.
+ *
+ * Die Namen der Zonen müssen Stringkonstanten sein, es wird nur der Zeiger gespeichert.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+namespace ppltk {
+namespace trace {
+
+extern std::atomic<bool> enabled;
+
+class Zone
+{
+private:
+    const char* name;
+    uint64_t start;
+    void begin(const char* name);
+    void end();
+public:
+    Zone(const char* name)
+    {
+        this->name=NULL;
+        if (enabled.load(std::memory_order_relaxed)) begin(name);
+    }
+    ~Zone()
+    {
+        if (name) end();
+    }
+};
+
+void setEnabled(bool enable);
+bool isEnabled();
+void clear();
+size_t bufferSize();
+bool writeChromeTrace(const char* filename);
+
+} // EOF namespace trace
+} // EOF namespace ppltk
+
+#ifndef PPLTK_NO_TRACING
+#define PPLTK_TRACE_CONCAT2(a, b) a##b
+#define PPLTK_TRACE_CONCAT(a, b) PPLTK_TRACE_CONCAT2(a, b)
+#define PPLTK_TRACE_ZONE(name) ppltk::trace::Zone PPLTK_TRACE_CONCAT(ppltk_trace_zone_, __LINE__)(name)
+#else
+#define PPLTK_TRACE_ZONE(name)
+#endif
+
+#endif
@@ -42,6 +42,9 @@
 
 
 #include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 
@@ -413,6 +416,7 @@ public:
     EventHandler();
     virtual ~EventHandler();
     void setEventHandler(EventHandler* handler);
+    EventHandler* getEventHandler() const;
 
     virtual void closeEvent(Event* event);
     virtual void quitEvent(Event* event);
@@ -532,12 +536,192 @@ public:
     SizePolicy();
 };
 
+class FrameStats
+{
+public:
+    class PaintTime {
+    public:
+        PaintTime();
+        size_t count;
+        double time;
+    };
+    FrameStats();
+    void clear();
+    size_t widgetsPainted;
+    size_t widgetsSkipped;
+    size_t bytesUploaded;
+    size_t eventsDispatched;
+    size_t layoutRecalculations;
+    double eventTime;
+    double drawTime;
+    std::map<String, PaintTime> paintTime;
+};
+
+class ChromeCache
+{
+public:
+    class Key
+    {
+    public:
+        Key(const char* type, const Size& size, int state, const Color& c1, const Color& c2 = Color(), const Color& c3 = Color());
+        const char* type;
+        int width, height;
+        int state;
+        uint32_t color[3];
+        bool operator<(const Key& other) const;
+    };
+
+private:
+    class Entry
+    {
+    public:
+        Image image;
+        std::list<Key>::iterator lru;
+    };
+    std::map<Key, Entry> cache;
+    std::list<Key> lru;
+    size_t memory;
+    size_t budget;
+    size_t hitCount, missCount;
+    void evict(size_t required);
+
+public:
+    ChromeCache();
+    Drawable* lookup(const Key& key, bool& created);
+    void clear();
+    void setMemoryBudget(size_t bytes);
+    size_t memoryBudget() const;
+    size_t memoryUsage() const;
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+};
+
+class GlyphMetrics
+{
+private:
+    Font	myFont;
+    int		lineHeight;
+    int		asciiAdvance[128];
+    short	asciiKerning[128 * 128];
+    std::map<wchar_t, int> advances;
+    std::map<uint64_t, int> kernings;
+    GlyphMetrics(const Font& font);
+    int measureAdvance(wchar_t c);
+    int measureKerning(wchar_t left, wchar_t right);
+
+public:
+    static GlyphMetrics& get(const Font& font);
+    int height() const;
+    int advance(wchar_t c);
+    int kerning(wchar_t left, wchar_t right);
+    int width(const WideString& text);
+    int width(const WideString& text, size_t start, size_t end);
+    void prefixWidths(const WideString& text, std::vector<int>& widths);
+};
+
+class TextBuffer
+{
+private:
+    typedef std::vector<wchar_t> Chunk;
+    std::vector<std::shared_ptr<Chunk> > chunks;
+    std::vector<size_t> index;
+    size_t total;
+
+    void rebuildIndex();
+    void addToIndex(size_t chunk, size_t added, size_t removed);
+    size_t findChunk(size_t pos, size_t& offset) const;
+    Chunk& writableChunk(size_t chunk);
+    void appendChunks(std::vector<std::shared_ptr<Chunk> >& result, const wchar_t* text, size_t size) const;
+
+public:
+    class const_iterator
+    {
+        friend class TextBuffer;
+    private:
+        const TextBuffer* buffer;
+        size_t chunk;
+        size_t offset;
+        size_t pos;
+    public:
+        const_iterator();
+        wchar_t operator*() const;
+        const_iterator& operator++();
+        size_t position() const;
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+    };
+
+    TextBuffer();
+    TextBuffer(const WideString& text);
+    TextBuffer& operator=(const WideString& text);
+
+    size_t size() const;
+    bool isEmpty() const;
+    bool notEmpty() const;
+    void clear();
+    void set(const WideString& text);
+    void insert(size_t pos, const WideString& text);
+    void erase(size_t pos, size_t count);
+    wchar_t operator[](size_t pos) const;
+    WideString mid(size_t pos, size_t count = (size_t)-1) const;
+    WideString toWideString() const;
+    bool operator==(const TextBuffer& other) const;
+    bool operator!=(const TextBuffer& other) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator at(size_t pos) const;
+};
+
+class TextRunCache
+{
+private:
+    class Key
+    {
+    public:
+        String text;
+        String fontName;
+        int fontSize;
+        int flags;
+        bool operator<(const Key& other) const;
+    };
+    class Entry
+    {
+    public:
+        Image mask;
+        Size size;
+        int padding;
+        std::list<Key>::iterator lru;
+    };
+    std::map<Key, Entry> cache;
+    std::list<Key> lru;
+    size_t memory;
+    size_t budget;
+    size_t hitCount, missCount;
+    const Entry* find(const Font& font, const String& text);
+    void evict(size_t required);
+
+public:
+    TextRunCache();
+    Size measure(const Font& font, const String& text);
+    void print(Drawable& draw, const Font& font, int x, int y, const String& text);
+    void clear();
+    void setMemoryBudget(size_t bytes);
+    size_t memoryBudget() const;
+    size_t memoryUsage() const;
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+};
+
 class Layout;
 
 
 class Widget : public EventHandler
 {
     friend class WindowManager;
+    friend class Window;
 private:
     Widget* parent;
     Layout* myLayout;
@@ -555,16 +739,31 @@ private:
     bool		enabled;
     bool		needsredraw;
     bool		child_needsredraw;
+    bool		partial_redraw;
     bool		topMost;
     bool		transparent;
     bool		deleteRequested;
     bool		modal;
     bool        use_own_drawbuffer;
+    bool        use_layer;
     bool        depug_paint;
+    bool        stats_excluded;
     String		myName;
+    Rect		damage_rect;
+    Rect		layer_damage;
     void updateDrawbuffer();
     void markWidgetsAboveForRedraw(Widget* widget);
     void sendResizeEvent();
+    void reportDamage(const Rect& r);
+    void findOccludedChilds(std::vector<char>& occluded) const;
+    Rect expandRedrawClip(const Rect& clip) const;
+    void redraw(Drawable& d, const Rect& clip);
+    void paintDebugFrame(Drawable& draw);
+
+protected:
+    virtual void addDamageRect(const Rect& r);
+    virtual void compositionChanged();
+    void setExcludedFromFrameStats(bool flag);
 
 public:
     Widget();
@@ -581,6 +780,8 @@ public:
     Widget* getTopmostParent() const;
 
     void setUseOwnDrawbuffer(bool enable);
+    void setLayered(bool enable);
+    bool isLayered() const;
     void destroyChilds();
 
     void setLayout(Layout* layout);
@@ -642,6 +843,7 @@ public:
     void removeChild(Widget* w);
 
     void needsRedraw();
+    void needsRedraw(const Rect& r);
     void childNeedsRedraw();
     void parentMustRedraw();
     void geometryChanged();
@@ -650,6 +852,13 @@ public:
     void draw(Drawable& d);
     void redraw(Drawable& d);
     bool redrawRequired() const;
+    static size_t culledPaintCount();
+    static size_t paintedWidgetCount();
+    static size_t skippedWidgetCount();
+    static size_t layoutRecalculationCount();
+    static void setPaintProfiling(bool enable);
+    static void takePaintProfile(std::map<String, FrameStats::PaintTime>& profile);
+    static void setHighlightRepaints(bool enable);
     void setName(const String& name);
     const String& name() const;
 
@@ -658,7 +867,10 @@ public:
 
 
     virtual String widgetType() const;
+    virtual bool isOpaque() const;
+    virtual bool canPaintPartially() const;
     virtual void paint(Drawable& draw);
+    virtual void paint(Drawable& draw, const Rect& clip);
     virtual ppl7::grafix::Size sizeHint() const;
     virtual ppl7::grafix::Size minimumSizeHint() const;
 
@@ -672,18 +884,22 @@ typedef struct PRIV_WINDOW_FUNCTIONS {
     void (*setWindowIcon) (void* privatedata, const Drawable& Icon);
     void (*createSurface) (void* privatedata);
     void (*createTexture) (void* privatedata);
-    Drawable(*lockWindowSurface) (void* privatedata);
-    void (*unlockWindowSurface) (void* privatedata);
+    void (*getWindowSurfaceFormat) (void* privatedata, Size& size, RGBFormat& format);
+    size_t(*uploadWindowSurface) (void* privatedata, const Drawable& surface, const std::vector<Rect>& spans);
     void (*drawWindowSurface) (void* privatedata);
     void* (*getRenderer) (void* privatedata);
     void (*clearScreen) (void* privatedata);
     void (*presentScreen) (void* privatedata);
+    size_t(*uploadLayer) (void* privatedata, const void* layer, const Drawable& surface, const Rect& dirty);
+    void (*drawLayer) (void* privatedata, const void* layer, const Rect& dest);
+    void (*releaseLayer) (void* privatedata, const void* layer);
 } PRIV_WINDOW_FUNCTIONS;
 
 
 class Window : public Widget
 {
     friend class WindowManager;
+    friend class Widget;
 private:
     void* privateData;
     PRIV_WINDOW_FUNCTIONS* fn;
@@ -699,6 +915,30 @@ private:
     bool uiSizeIsFixed;
     Size myUiSize;
     Size myWindowSize;
+    Image myWindowSurface;
+    Rect myDamageRect;
+    std::vector<Rect> myDamageSpans;
+    size_t myUploadedBytes;
+    size_t myCulledPaints;
+    void updateWindowSurface(bool redrawAll);
+    int myFrameRateLimit;
+    double myLastPresentTime;
+    double myFpsTime;
+    int myFpsCount;
+    void updateFps(double now);
+    std::vector<Widget*> myLayers;
+    bool myCompositionChanged;
+    size_t uploadLayers();
+    void drawLayers();
+    Point layerPosition(const Widget* w) const;
+    void forgetLayers();
+    static void collectLayers(const Widget* w, std::vector<Widget*>& layers);
+    static void releaseLayer(const Widget* w);
+    static void evictLayers();
+
+protected:
+    virtual void addDamageRect(const Rect& r);
+    virtual void compositionChanged();
 
 public:
     enum WindowFlags {
@@ -735,6 +975,22 @@ public:
         int			refresh_rate;
     };
 
+    class FrameStatistics {
+    public:
+        FrameStatistics();
+        uint64_t	framesPresented;
+        uint64_t	framesSkipped;
+        double		frameTime;
+        double		averageFrameTime;
+        double		maxFrameTime;
+        int			fps;
+    };
+
+private:
+    FrameStatistics myFrameStats;
+    FrameStats myDrawStats;
+
+public:
     Window();
     ~Window();
     uint32_t flags() const;
@@ -762,6 +1018,23 @@ public:
 
     void drawWidgets();
     void redrawWidgets();
+    const Rect& damageRect() const;
+    const std::vector<Rect>& damageSpans() const;
+    size_t uploadedBytes() const;
+    const Image& windowSurface() const;
+    Image screenshot() const;
+    size_t culledPaints() const;
+
+    bool renderFrame(bool force = false);
+    double nextFrameDelay() const;
+    void setFrameRateLimit(int fps);
+    int frameRateLimit() const;
+    const FrameStatistics& frameStatistics() const;
+    const FrameStats& drawStatistics() const;
+
+    static void setLayerMemoryBudget(size_t bytes);
+    static size_t layerMemoryBudget();
+    static size_t layerMemoryUsage();
 
     void* getPrivateData();
     void setPrivateData(void* data, WindowManager* wm, PRIV_WINDOW_FUNCTIONS* fn);
@@ -790,9 +1063,18 @@ private:
     Widget* KeyboardFocus;
     Widget* GameControllerFocus;
     Widget* grabMouseWidget;
+    FrameStats	currentFrameStats;
+    FrameStats	lastFrameStats;
+    bool		frameStatsEnabled;
+    ChromeCache	myChromeCache;
+    TextRunCache	myTextRunCache;
     void updateButtonSymbols();
     void deferedDeleteWidgets(Widget* widget);
 
+protected:
+    void countDispatchedEvent();
+    void addEventTime(double ms);
+
 public:
     ImageList	ButtonSymbols;
     ImageList	Toolbar;
@@ -802,6 +1084,8 @@ public:
     virtual ~WindowManager();
     const WidgetStyle& getWidgetStyle() const;
     void setWidgetStyle(const WidgetStyle& style);
+    ChromeCache& chromeCache();
+    TextRunCache& textRunCache();
     void dispatchMouseEvent(Window* window, MouseEvent& event);
     void dispatchClickEvent(Window* window);
     void setDoubleClickIntervall(int ms);
@@ -816,6 +1100,11 @@ public:
     int getDoubleClickIntervall() const;
     Widget* findMouseWidget(Widget* window, Point& p);
 
+    const FrameStats& frameStats() const;
+    void setFrameStatsEnabled(bool enable);
+    bool isFrameStatsEnabled() const;
+    bool finishFrame(FrameStats& drawStats);
+
     virtual void createWindow(Window& w) = 0;
     virtual void destroyWindow(Window& w) = 0;
     virtual void setWindowPosition(Window& w, int x, int y) = 0;
@@ -829,6 +1118,7 @@ public:
     virtual void getMouseState(Point& p, int& buttonMask) const = 0;
     virtual void startEventLoop() = 0;
     virtual void handleEvents() = 0;
+    virtual void wakeEventLoop();
     virtual size_t numWindows() = 0;
     virtual void startClickEvent(Window* win) = 0;
     virtual int startTimer(Widget* w, int intervall) = 0;
@@ -851,7 +1141,7 @@ private:
     Size		screenSize;
     int			screenRefreshRate;
 
-    List<Window*>	windows;
+    std::list<Window*>	windows;
     Window* lastWindowEnterEvent;
 
     void DispatchSdlActiveEvent(void* e);
@@ -863,6 +1153,7 @@ private:
     void DispatchQuitEvent(void* e);
 
     void DispatchWindowEvent(void* e);
+    int drawPendingWindows();
 
     Window* getWindow(uint32_t id);
 
@@ -882,6 +1173,7 @@ public:
     virtual void getMouseState(Point& p, int& buttonMask) const;
     virtual void startEventLoop();
     virtual void handleEvents();
+    virtual void wakeEventLoop();
     virtual size_t numWindows();
     virtual void startClickEvent(Window* win);
 
@@ -905,7 +1197,7 @@ private:
     Size		screenSize;
     int			screenRefreshRate;
 
-    List<Window*>	windows;
+    std::list<Window*>	windows;
     Window* lastWindowEnterEvent;
 
     void DispatchSdlActiveEvent(void* e);
@@ -917,6 +1209,7 @@ private:
     void DispatchQuitEvent(void* e);
 
     void DispatchWindowEvent(void* e);
+    int drawPendingWindows();
 
     Window* getWindow(uint32_t id);
 
@@ -936,6 +1229,7 @@ public:
     virtual void getMouseState(Point& p, int& buttonMask) const;
     virtual void startEventLoop();
     virtual void handleEvents();
+    virtual void wakeEventLoop();
     virtual size_t numWindows();
     virtual void startClickEvent(Window* win);
 
@@ -952,6 +1246,71 @@ public:
     void* getSDLWindow(Window& w);
 };
 
+class WindowManager_Headless : public WindowManager
+{
+private:
+    class Timer {
+    public:
+        Widget* widget;
+        Window* clickWindow;
+        int intervall;
+        uint64_t due;
+    };
+    RGBFormat	screenRGBFormat;
+    Size		screenSize;
+    MouseState	mouse;
+    String		clipboard;
+    uint64_t	clock;
+    int			nextTimerId;
+
+    std::list<Window*>	windows;
+    std::map<int, Timer> timers;
+
+    void drawPendingWindows();
+
+public:
+    WindowManager_Headless(int width = 1920, int height = 1080);
+    ~WindowManager_Headless();
+    virtual void createWindow(Window& w);
+    virtual void destroyWindow(Window& w);
+    virtual void setWindowPosition(Window& w, int x, int y);
+    virtual void resizeWindow(Window& w, int width, int height);
+    virtual void setWindowDisplayMode(Window& w, const Window::DisplayMode& mode);
+
+    virtual const Size& desktopResolution() const;
+    virtual const RGBFormat& desktopRGBFormat() const;
+    virtual MouseState getMouseState() const;
+    virtual void getMouseState(Point& p, int& buttonMask) const;
+    virtual void startEventLoop();
+    virtual void handleEvents();
+    virtual void wakeEventLoop();
+    virtual size_t numWindows();
+    virtual void startClickEvent(Window* win);
+
+    virtual void setClipboardText(const ppl7::String& text);
+    virtual bool hasClipboardText() const;
+    virtual String getClipboardText() const;
+
+    int startTimer(Widget* w, int intervall);
+    void removeTimer(int timer_id);
+
+    const Image& windowSurface(Window& w) const;
+    uint64_t currentTime() const;
+    void advanceTime(int ms);
+
+    void sendMouseMove(Window& w, int x, int y);
+    void sendMouseDown(Window& w, int x, int y, MouseState::MouseButton button = MouseState::Left, int clicks = 1);
+    void sendMouseUp(Window& w, int x, int y, MouseState::MouseButton button = MouseState::Left, int clicks = 1);
+    void sendMouseClick(Window& w, int x, int y, MouseState::MouseButton button = MouseState::Left);
+    void sendMouseWheel(Window& w, int x, int y);
+    void sendKeyDown(int key, int modifier = 0, bool repeat = false);
+    void sendKeyUp(int key, int modifier = 0);
+    void sendTextInput(const String& text);
+    void sendResize(Window& w, int width, int height);
+    void sendClose(Window& w);
+    void sendQuit(Window& w);
+};
+
 
 
 
@@ -965,6 +1324,7 @@ private:
     bool	isDown;
     bool	is_checkable;
     bool	is_checked;
+    void paintChrome(Drawable& draw);
 public:
     Button(const String& text = String(), const Drawable& icon = Drawable());
     Button(int x, int y, int width, int height, const String& text = String(), const Drawable& icon = Drawable());
@@ -1003,6 +1363,7 @@ class Frame : public Widget
 private:
     int		myBorderStyle;
     Color	myBackground, myBorderColorLight, myBorderColorShadow;
+    void paintChrome(Drawable& draw);
 public:
     enum BorderStyle {
         NoBorder = 0,
@@ -1023,6 +1384,7 @@ public:
     void setBorderColorShadow(const Color& c);
 
     String widgetType() const override;
+    bool isOpaque() const override;
     void paint(Drawable& draw) override;
 };
 
@@ -1140,6 +1502,25 @@ public:
     ppl7::grafix::Size minimumSizeHint() const override;
 };
 
+class FrameStatsOverlay : public Widget
+{
+private:
+    FrameStats stats;
+    Font myFont;
+    int timer_id;
+    bool enabledStats;
+
+public:
+    FrameStatsOverlay(int x, int y, int width = 280, int height = 220);
+    ~FrameStatsOverlay();
+
+    void setHighlightRepaints(bool enable);
+
+    String widgetType() const override;
+    void paint(Drawable& draw) override;
+    void timerEvent(Event* event) override;
+};
+
 class InputValidator
 {
 public:
@@ -1147,6 +1528,22 @@ public:
     virtual bool validateInput(const ppl7::WideString& text) = 0;
 };
 
+class Caret
+{
+private:
+    Color	myColor;
+    Rect	myRect;
+    bool	lit;
+public:
+    Caret();
+    const Color& color() const;
+    void setColor(const Color& c);
+    bool isLit() const;
+    const Rect& rect() const;
+    bool update(int x, int y, int width, int height, bool lit, Rect& damage);
+    void paint(Drawable& draw, int x, int y) const;
+};
+
 class LineInput : public Frame
 {
 private:
@@ -1181,7 +1578,12 @@ private:
     int		drag_start_position;
     int		timerId;
     InputValidator* validator;
+    std::vector<int> prefixWidth;
+    Caret	caret;
 
+    void updateCaret();
+    void rebuildPrefixWidths();
+    void updatePrefixWidths(size_t pos, size_t removed, size_t inserted);
     void calcSelectionPosition();
     void calcCursorPosition();
     int calcPosition(int x);
@@ -1205,7 +1607,9 @@ public:
     void setInputValidator(InputValidator* validator);
 
     String widgetType() const override;
+    bool canPaintPartially() const override;
     void paint(Drawable& draw) override;
+    void paint(Drawable& draw, const Rect& clip) override;
     ppl7::grafix::Size sizeHint() const override;
     ppl7::grafix::Size minimumSizeHint() const override;
 
@@ -1238,6 +1642,10 @@ private:
     int drag_offset;
     ppl7::grafix::Point drag_start_pos;
 
+    ppl7::grafix::Rect indicatorRect() const;
+    void indicatorNeedsRedraw();
+    void paintSlider(ppl7::grafix::Drawable& draw, const ppl7::grafix::Rect& r);
+
 public:
     Scrollbar(int x, int y, int width, int height);
     ~Scrollbar();
@@ -1249,7 +1657,9 @@ public:
     int size() const;
 
     virtual ppl7::String widgetType() const override;
+    virtual bool canPaintPartially() const override;
     virtual void paint(ppl7::grafix::Drawable& draw) override;
+    virtual void paint(ppl7::grafix::Drawable& draw, const ppl7::grafix::Rect& clip) override;
     void mouseDownEvent(ppltk::MouseEvent* event) override;
     void mouseUpEvent(ppltk::MouseEvent* event) override;
     void lostFocusEvent(ppltk::FocusEvent* event) override;
@@ -1276,23 +1686,37 @@ private:
         void go(int start, int end);
     };
 
-    class CacheItem
+    class GlyphLayout
+    {
+    public:
+        std::vector<int> x;
+        std::vector<int> width;
+        std::vector<int> line;
+
+        size_t size() const;
+        void append(int x, int width, int line);
+    };
+
+    class Paragraph
     {
     public:
-        wchar_t letter;
-        ppl7::grafix::Point p;
-        ppl7::grafix::Size size;
-        int line;
+        size_t start;
+        int first_line;
+        int lines;
+        std::vector<size_t> rows;
+        GlyphLayout glyphs;
     };
 
-    ppl7::WideString myText;
-    ppl7::WideString validatedText;
+    TextBuffer myText;
+    TextBuffer validatedText;
+    mutable ppl7::WideString textCopy;
+    mutable bool textCopyValid;
     ppl7::grafix::Font myFont;
     ppl7::grafix::Color myColor;
     ppl7::WideString placeholder;
     Scrollbar* vertical_scrollbar;
 
-    std::map<size_t, CacheItem> position_cache;
+    std::vector<Paragraph> paragraphs;
     bool cache_is_valid;
 
     size_t	cursorpos;
@@ -1312,16 +1736,27 @@ private:
     int     visible_lines;
     int     first_cursor_up_down_x;
     InputValidator* validator;
+    Caret	caret;
 
     void calcCursorPosition();
     int calcPosition(const ppl7::grafix::Point& p);
     ppl7::grafix::Point getDrawStartPositionOfChar(size_t pos);
-    void validateAndSendEvent(const WideString& text);
+    void validateAndSendEvent();
     void deleteSelection();
-    void addToCache(const ppl7::WideString& word, int x, int y, int line);
+    void insertText(const WideString& text);
+    void addToCache(GlyphLayout& glyphs, const ppl7::WideString& word, int x, int line);
     void invalidateCache();
     void rebuildCache(int width);
-    void paintSelection(Drawable& draw);
+    void layoutParagraphs(size_t start, size_t end, int first_line, std::vector<Paragraph>& result);
+    void textChanged(size_t pos, size_t removed, size_t inserted);
+    size_t findParagraph(size_t pos) const;
+    size_t findParagraphOfLine(int line) const;
+    size_t positionOfLine(int line) const;
+    void visibleLines(const Rect& area, int& first, int& last) const;
+    size_t glyphCount() const;
+    void paintSelection(Drawable& draw, const Rect& area);
+    void paintText(Drawable& draw, const Rect& area);
+    void updateCaret();
     void enableScrollbar(bool enable);
     void updateScrollbar();
     void moveScrollbarToCursor();
@@ -1346,7 +1781,9 @@ public:
     void setInputValidator(InputValidator* validator);
 
     String widgetType() const override;
+    bool canPaintPartially() const override;
     void paint(Drawable& draw) override;
+    void paint(Drawable& draw, const Rect& clip) override;
     ppl7::grafix::Size sizeHint() const override;
     ppl7::grafix::Size minimumSizeHint() const override;
 
@@ -1378,6 +1815,7 @@ public:
     void setChecked(bool checked);
 
     ppl7::String widgetType() const override;
+    bool isOpaque() const override;
     void paint(ppl7::grafix::Drawable& draw) override;
     void mouseDownEvent(ppltk::MouseEvent* event) override;
 };
@@ -1394,10 +1832,30 @@ public:
     bool checked() const;
     void setChecked(bool checked);
     ppl7::String widgetType() const override;
+    bool isOpaque() const override;
     void paint(ppl7::grafix::Drawable& draw) override;
     void mouseDownEvent(ppltk::MouseEvent* event) override;
 };
 
+/*!\brief Hashfunktion für ppl7::String in std::unordered_map
+ */
+class StringHash
+{
+public:
+    size_t operator()(const ppl7::String& str) const;
+};
+
+class ListModel
+{
+public:
+    virtual ~ListModel() {};
+    virtual size_t rowCount() const = 0;
+    virtual ppl7::String data(size_t row) const = 0;
+    virtual ppl7::String identifier(size_t row) const;
+    virtual bool findText(const ppl7::String& text, size_t& row) const;
+    virtual bool findIdentifier(const ppl7::String& identifier, size_t& row) const;
+};
+
 class ListWidget : public ppltk::Frame
 {
 public:
@@ -1409,18 +1867,60 @@ public:
         size_t index;
     };
 private:
+    class ItemModel : public ListModel
+    {
+    private:
+        typedef std::unordered_map<ppl7::String, size_t, StringHash> Index;
+        Index textIndex;
+        Index identifierIndex;
+        std::vector<ppl7::String> collationKeys;
+        std::vector<size_t> order;
+        bool sorted;
+        bool orderDirty;
+        SortOrder sortOrder;
+
+        static void indexRow(Index& index, const ppl7::String& key, size_t row);
+        void unindexRow(Index& index, const ppl7::String& key, size_t row, bool is_text);
+        int compare(size_t a, size_t b) const;
+        bool less(size_t a, size_t b) const;
+
+    public:
+        std::vector<ListWidgetItem> items;
+        size_t revision;
+        ItemModel();
+        static ppl7::String collationKey(const ppl7::String& text);
+        size_t itemRow(size_t row) const;
+        size_t displayRow(size_t item) const;
+        size_t rowCount() const override;
+        ppl7::String data(size_t row) const override;
+        ppl7::String identifier(size_t row) const override;
+        bool findText(const ppl7::String& text, size_t& row) const override;
+        bool findIdentifier(const ppl7::String& identifier, size_t& row) const override;
+        size_t append(const ppl7::String& text, const ppl7::String& identifier, bool keep_sorted = true);
+        void erase(size_t row);
+        void clear();
+        void reindex();
+        void setSorted(bool enable);
+        bool isSorted() const;
+        bool isOrderDirty() const;
+        void setSortOrder(SortOrder sort);
+        void resort();
+        void sortItems(SortOrder sort, size_t& item);
+    };
+    ItemModel itemModel;
+    ListModel* model;
     Scrollbar* scrollbar;
     ppl7::String myCurrentText;
     ppl7::String myCurrentIdentifier;
     size_t myCurrentIndex;
     size_t visibleItems;
     int mouseOverIndex;
-    bool sortingEnabled;
+    int updateDepth;
+    mutable std::list<ListWidgetItem> itemList;
+    mutable size_t itemListRevision;
 
-    std::list<ListWidgetItem> items;
-    std::map<ppl7::String, const ListWidgetItem&> sorted_items;
-
-    void updateSortedItems();
+    void updateScrollbar();
+    void rowNeedsRedraw(int index);
 
 public:
     ListWidget(int x, int y, int width, int height);
@@ -1429,9 +1929,15 @@ public:
     ppl7::String currentIdentifier() const;
 
     void setCurrentIndex(size_t index);
+    void setCurrentIdentifier(const ppl7::String& identifier);
     size_t currentIndex() const;
 
     const std::list<ListWidgetItem>& getItems() const;
+    const std::vector<ListWidgetItem>& items() const;
+    const ListWidgetItem& itemAt(size_t row) const;
+    void setModel(ListModel* model);
+    ListModel* getModel() const;
+    void modelChanged();
     bool hasIdentifier(const ppl7::String& identifier) const;
     bool hasText(const ppl7::String& text) const;
     void setSortingEnabled(bool enable);
@@ -1440,12 +1946,17 @@ public:
 
     void clear();
 
+    void beginUpdate();
+    void endUpdate();
     void add(const ppl7::String& text, const ppl7::String& identifier = ppl7::String());
+    void addItems(const std::vector<ListWidgetItem>& items);
     void remove(size_t index);
     void remove(const ppl7::String& identifier);
 
     ppl7::String widgetType() const override;
+    bool canPaintPartially() const override;
     void paint(ppl7::grafix::Drawable& draw) override;
+    void paint(ppl7::grafix::Drawable& draw, const ppl7::grafix::Rect& clip) override;
     void valueChangedEvent(ppltk::Event* event, int value) override;
     void mouseDownEvent(ppltk::MouseEvent* event) override;
     void mouseWheelEvent(ppltk::MouseEvent* event) override;
@@ -1468,10 +1979,18 @@ private:
         ppl7::String identifier;
         size_t index;
     };
-    std::list<ComboBoxItem> items;
+    typedef std::unordered_map<ppl7::String, size_t, StringHash> Index;
+    std::vector<ComboBoxItem> items;
+    Index textIndex;
+    Index identifierIndex;
+    bool indexDirty;
+    int updateDepth;
 
     ListWidget* selection;
 
+    void selectItem(size_t index);
+    void reindex();
+
 public:
     ComboBox(int x, int y, int width, int height);
     ~ComboBox();
@@ -1487,7 +2006,10 @@ public:
 
     void clear();
 
+    void beginUpdate();
+    void endUpdate();
     void add(const ppl7::String& text, const ppl7::String& identifier = ppl7::String());
+    void addItems(const std::vector<ListWidget::ListWidgetItem>& items);
 
     ppl7::String widgetType() const override;
     void paint(ppl7::grafix::Drawable& draw) override;
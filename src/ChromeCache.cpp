@@ -0,0 +1,180 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+
+#include <string.h>
+#include "ppltk.h"
+
+
+namespace ppltk {
+
+using namespace ppl7;
+using namespace ppl7::grafix;
+
+/*!\class ChromeCache
+ * \brief Cache für vorgezeichnete Widget-Hintergründe
+ *
+ * \desc
+ * Viele Widgets zeichnen bei jedem Neuzeichnen den gleichen Hintergrund aus
+ * Farbverläufen und Rahmenlinien, der nur von Größe, Zustand und Farben abhängt.
+ * Der ChromeCache hält solche Hintergründe als Image vor, so dass z.B. hunderte
+ * gleicher Buttons einer Toolbar ihn nur einmal berechnen und danach kopieren.
+ * \par
+ * Der Cache ist durch ein Speicherbudget begrenzt, bei dessen Überschreitung die am
+ * längsten nicht verwendeten Einträge verworfen werden. Einträge, die mehr als ein
+ * Sechzehntel des Budgets belegen würden, werden nicht gespeichert.
+ */
+
+/*!\brief Schlüssel eines Cache-Eintrags
+ *
+ * \param type Name des Widget-Typs. Es muss eine Zeichenkette sein, die während der
+ * gesamten Laufzeit gültig bleibt, in der Regel ein String-Literal.
+ * \param size Größe des Hintergrunds
+ * \param state Zustand des Widgets, z.B. gedrückt oder Rahmenstil
+ * \param c1 Erste Farbe, aus der der Hintergrund berechnet wird
+ * \param c2 Optionale zweite Farbe
+ * \param c3 Optionale dritte Farbe
+ */
+ChromeCache::Key::Key(const char* type, const Size& size, int state, const Color& c1, const Color& c2, const Color& c3)
+{
+	this->type=type;
+	width=size.width;
+	height=size.height;
+	this->state=state;
+	color[0]=c1.color();
+	color[1]=c2.color();
+	color[2]=c3.color();
+}
+
+bool ChromeCache::Key::operator<(const Key& other) const
+{
+	if (width != other.width) return width < other.width;
+	if (height != other.height) return height < other.height;
+	if (state != other.state) return state < other.state;
+	for (int i=0;i < 3;i++) {
+		if (color[i] != other.color[i]) return color[i] < other.color[i];
+	}
+	if (type == other.type) return false;
+	return strcmp(type, other.type) < 0;
+}
+
+ChromeCache::ChromeCache()
+{
+	memory=0;
+	budget=8 * 1024 * 1024;
+	hitCount=0;
+	missCount=0;
+}
+
+/*!\brief Eintrag suchen oder anlegen
+ *
+ * \desc
+ * Sucht den Hintergrund zu \p key. Ist er noch nicht vorhanden, wird ein neues Image
+ * in der Größe des Schlüssels angelegt und \p created auf \c true gesetzt. Der Aufrufer
+ * muss den Hintergrund dann hineinzeichnen.
+ *
+ * \param key Schlüssel
+ * \param created Wird auf \c true gesetzt, wenn der Eintrag neu angelegt wurde
+ * \return Zeiger auf das Image oder NULL, wenn der Hintergrund zu groß für den Cache
+ * ist. In diesem Fall muss der Aufrufer direkt in sein Drawable zeichnen.
+ */
+Drawable* ChromeCache::lookup(const Key& key, bool& created)
+{
+	created=false;
+	std::map<Key, Entry>::iterator it=cache.find(key);
+	if (it != cache.end()) {
+		hitCount++;
+		lru.splice(lru.begin(), lru, it->second.lru);
+		return &it->second.image;
+	}
+	missCount++;
+	if (key.width <= 0 || key.height <= 0) return NULL;
+	size_t bytes=(size_t)key.width * key.height * 4;
+	if (bytes > budget / 16) return NULL;
+	evict(bytes);
+	Entry& e=cache[key];
+	e.image.create(key.width, key.height, RGBFormat::A8R8G8B8);
+	lru.push_front(key);
+	e.lru=lru.begin();
+	memory+=bytes;
+	created=true;
+	return &e.image;
+}
+
+void ChromeCache::evict(size_t required)
+{
+	while (memory + required > budget && lru.size() > 0) {
+		std::map<Key, Entry>::iterator it=cache.find(lru.back());
+		memory-=(size_t)it->first.width * it->first.height * 4;
+		cache.erase(it);
+		lru.pop_back();
+	}
+}
+
+void ChromeCache::clear()
+{
+	cache.clear();
+	lru.clear();
+	memory=0;
+}
+
+void ChromeCache::setMemoryBudget(size_t bytes)
+{
+	budget=bytes;
+	evict(0);
+}
+
+size_t ChromeCache::memoryBudget() const
+{
+	return budget;
+}
+
+size_t ChromeCache::memoryUsage() const
+{
+	return memory;
+}
+
+size_t ChromeCache::size() const
+{
+	return cache.size();
+}
+
+size_t ChromeCache::hits() const
+{
+	return hitCount;
+}
+
+size_t ChromeCache::misses() const
+{
+	return missCount;
+}
+
+
+}	// EOF namespace ppltk
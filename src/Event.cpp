@@ -219,6 +219,11 @@ void EventHandler::setEventHandler(EventHandler* handler)
 	this->handler=handler;
 }
 
+EventHandler* EventHandler::getEventHandler() const
+{
+	return handler;
+}
+
 void EventHandler::mouseMoveEvent(MouseEvent* event)
 {
 #ifdef EVENT_DEBUG
@@ -0,0 +1,211 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+
+#include "ppltk.h"
+
+
+namespace ppltk {
+
+using namespace ppl7;
+using namespace ppl7::grafix;
+
+/*!\class GlyphMetrics
+ * \brief Breiten der Zeichen einer Schriftart
+ *
+ * \desc
+ * Texteingaben müssen für Cursor, Selektion, Zeilenumbruch und Mausklicks ständig
+ * die Breite von Teilstrings kennen. Statt dafür jedes Mal Font::measure aufzurufen,
+ * wird die Breite jedes Zeichens und der Kerning-Abstand jedes Zeichenpaares nur
+ * einmal pro Schriftart gemessen und in Tabellen gespeichert. Die Breite eines Textes
+ * ergibt sich dann in O(n) aus der Summe der Tabellenwerte.
+ * \par
+ * Die Tabellen werden zwischen allen Widgets mit gleicher Schriftart (Name, Größe,
+ * fett, kursiv, Antialiasing) geteilt und bei Bedarf gefüllt. Für ASCII-Zeichen
+ * liegen sie in Arrays, für alle anderen Zeichen in Maps.
+ * \par
+ * Da Font keinen Zugriff auf die Kerning-Tabelle bietet, wird der Abstand eines Paares
+ * aus der Differenz zwischen der Breite beider Zeichen zusammen und einzeln bestimmt.
+ * Die Summe stimmt daher mit Font::measure des ganzen Textes überein.
+ */
+
+class GlyphMetricsKey
+{
+public:
+	String name;
+	int size;
+	int flags;
+	bool operator<(const GlyphMetricsKey& other) const
+	{
+		if (size != other.size) return size < other.size;
+		if (flags != other.flags) return flags < other.flags;
+		return name < other.name;
+	}
+};
+
+// Markiert einen noch nicht gemessenen Eintrag der ASCII-Tabellen
+#define GLYPH_UNKNOWN	-32768
+
+static std::map<GlyphMetricsKey, GlyphMetrics*> glyph_metrics;
+
+GlyphMetrics::GlyphMetrics(const Font& font)
+{
+	myFont=font;
+	myFont.setOrientation(Font::TOP);
+	lineHeight=myFont.measure(WideString(L" ")).height;
+	for (int i=0;i < 128;i++) asciiAdvance[i]=GLYPH_UNKNOWN;
+	for (int i=0;i < 128 * 128;i++) asciiKerning[i]=GLYPH_UNKNOWN;
+}
+
+/*!\brief Tabellen einer Schriftart
+ *
+ * \desc
+ * Liefert die gemeinsamen Tabellen für die Schriftart \p font zurück und legt sie
+ * beim ersten Aufruf an. Farbe und Orientierung spielen keine Rolle.
+ */
+GlyphMetrics& GlyphMetrics::get(const Font& font)
+{
+	GlyphMetricsKey key;
+	key.name=font.name();
+	key.size=font.size();
+	key.flags=(font.bold() ? 1 : 0) | (font.italic() ? 2 : 0) | (font.antialias() ? 4 : 0);
+	std::map<GlyphMetricsKey, GlyphMetrics*>::iterator it=glyph_metrics.find(key);
+	if (it != glyph_metrics.end()) return *it->second;
+	GlyphMetrics* m=new GlyphMetrics(font);
+	glyph_metrics.insert(std::pair<GlyphMetricsKey, GlyphMetrics*>(key, m));
+	return *m;
+}
+
+/*!\brief Zeilenhöhe
+ */
+int GlyphMetrics::height() const
+{
+	return lineHeight;
+}
+
+int GlyphMetrics::measureAdvance(wchar_t c)
+{
+	WideString letter;
+	letter.set(c);
+	return myFont.measure(letter).width;
+}
+
+int GlyphMetrics::measureKerning(wchar_t left, wchar_t right)
+{
+	WideString pair;
+	pair.set(left);
+	pair.append(right);
+	return myFont.measure(pair).width - advance(left) - advance(right);
+}
+
+/*!\brief Breite eines Zeichens
+ */
+int GlyphMetrics::advance(wchar_t c)
+{
+	if (c >= 0 && c < 128) {
+		int& a=asciiAdvance[c];
+		if (a == GLYPH_UNKNOWN) a=measureAdvance(c);
+		return a;
+	}
+	std::map<wchar_t, int>::const_iterator it=advances.find(c);
+	if (it != advances.end()) return it->second;
+	int a=measureAdvance(c);
+	advances.insert(std::pair<wchar_t, int>(c, a));
+	return a;
+}
+
+/*!\brief Kerning-Abstand eines Zeichenpaares
+ *
+ * \return Korrektur in Pixel, die zur Summe der Breiten beider Zeichen addiert werden
+ * muss. Meist 0 oder negativ.
+ */
+int GlyphMetrics::kerning(wchar_t left, wchar_t right)
+{
+	if (left == '\n' || right == '\n') return 0;
+	if (left >= 0 && left < 128 && right >= 0 && right < 128) {
+		short& k=asciiKerning[left * 128 + right];
+		if (k == GLYPH_UNKNOWN) k=(short)measureKerning(left, right);
+		return k;
+	}
+	uint64_t key=((uint64_t)(uint32_t)left << 32) | (uint32_t)right;
+	std::map<uint64_t, int>::const_iterator it=kernings.find(key);
+	if (it != kernings.end()) return it->second;
+	int k=measureKerning(left, right);
+	kernings.insert(std::pair<uint64_t, int>(key, k));
+	return k;
+}
+
+/*!\brief Breite eines Textes
+ */
+int GlyphMetrics::width(const WideString& text)
+{
+	return width(text, 0, text.size());
+}
+
+/*!\brief Breite eines Teilstrings
+ *
+ * \param text Text
+ * \param start Position des ersten Zeichens
+ * \param end Position hinter dem letzten Zeichen
+ * \return Breite der Zeichen von \p start bis ausschließlich \p end
+ */
+int GlyphMetrics::width(const WideString& text, size_t start, size_t end)
+{
+	if (end > text.size()) end=text.size();
+	int w=0;
+	for (size_t i=start;i < end;i++) {
+		w+=advance(text[i]);
+		if (i + 1 < end) w+=kerning(text[i], text[i + 1]);
+	}
+	return w;
+}
+
+/*!\brief Breiten aller Anfänge eines Textes
+ *
+ * \desc
+ * Füllt \p widths mit text.size()+1 Werten. widths[i] ist die Breite der ersten
+ * \p i Zeichen, also die X-Position des Cursors vor dem Zeichen \p i.
+ */
+void GlyphMetrics::prefixWidths(const WideString& text, std::vector<int>& widths)
+{
+	size_t size=text.size();
+	widths.resize(size + 1);
+	widths[0]=0;
+	int x=0;
+	for (size_t i=0;i < size;i++) {
+		if (i > 0) x+=kerning(text[i - 1], text[i]);
+		widths[i + 1]=x + advance(text[i]);
+		x+=advance(text[i]);
+	}
+}
+
+
+
+}	// EOF namespace ppltk
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+#ifndef _PPLTK_RECTHELPER_INCLUDE
+#define _PPLTK_RECTHELPER_INCLUDE
+
+/*
+ * Interne Hilfsfunktionen für Rechtecke, die Widget, Window und Caret für Clip- und
+ * Damage-Bereiche brauchen. Rechtecke mit Breite oder Höhe <= 0 gelten als leer.
+ * Der Header wird nicht installiert und ist nicht Teil der API.
+ */
+
+namespace ppltk {
+namespace rect {
+
+static inline bool isEmpty(const ppl7::grafix::Rect& r)
+{
+	if (r.width() <= 0 || r.height() <= 0) return true;
+	return false;
+}
+
+static inline ppl7::grafix::Rect intersect(const ppl7::grafix::Rect& a, const ppl7::grafix::Rect& b)
+{
+	int x1=a.left() > b.left() ? a.left() : b.left();
+	int y1=a.top() > b.top() ? a.top() : b.top();
+	int x2=a.left() + a.width() < b.left() + b.width() ? a.left() + a.width() : b.left() + b.width();
+	int y2=a.top() + a.height() < b.top() + b.height() ? a.top() + a.height() : b.top() + b.height();
+	if (x2 <= x1 || y2 <= y1) return ppl7::grafix::Rect();
+	return ppl7::grafix::Rect(x1, y1, x2 - x1, y2 - y1);
+}
+
+static inline bool contains(const ppl7::grafix::Rect& outer, const ppl7::grafix::Rect& inner)
+{
+	if (inner.left() < outer.left() || inner.top() < outer.top()) return false;
+	if (inner.left() + inner.width() > outer.left() + outer.width()) return false;
+	if (inner.top() + inner.height() > outer.top() + outer.height()) return false;
+	return true;
+}
+
+static inline ppl7::grafix::Rect unite(const ppl7::grafix::Rect& a, const ppl7::grafix::Rect& b)
+{
+	if (isEmpty(a)) return b;
+	if (isEmpty(b)) return a;
+	int x1=a.left() < b.left() ? a.left() : b.left();
+	int y1=a.top() < b.top() ? a.top() : b.top();
+	int x2=a.left() + a.width() > b.left() + b.width() ? a.left() + a.width() : b.left() + b.width();
+	int y2=a.top() + a.height() > b.top() + b.height() ? a.top() + a.height() : b.top() + b.height();
+	return ppl7::grafix::Rect(x1, y1, x2 - x1, y2 - y1);
+}
+
+} // EOF namespace rect
+} // EOF namespace ppltk
+
+#endif
@@ -0,0 +1,369 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+
+#include "ppltk.h"
+
+
+namespace ppltk {
+
+using namespace ppl7;
+using namespace ppl7::grafix;
+
+/*!\class TextBuffer
+ * \brief Text für große Eingabefelder
+ *
+ * \desc
+ * Der Text wird in Blöcken von höchstens TEXTBUFFER_CHUNK Zeichen gespeichert. Einfügen
+ * und Löschen verschiebt daher nur die Zeichen eines Blocks statt des gesamten Textes.
+ * Welcher Block eine Position enthält, wird über einen Fenwick-Baum der Blockgrößen in
+ * O(log n) bestimmt. Läuft ein Block über, wird er geteilt und der Baum neu aufgebaut,
+ * was nur alle paar tausend Zeichen vorkommt.
+ * \par
+ * Die Blöcke werden zwischen Kopien geteilt und erst beim Schreiben kopiert. Eine Kopie
+ * des Puffers, etwa als zuletzt gültiger Stand eines Textes, kostet daher nur einen
+ * Zeiger pro Block.
+ */
+
+// Maximale Größe eines Blocks
+#define TEXTBUFFER_CHUNK	4096
+
+TextBuffer::const_iterator::const_iterator()
+{
+	buffer=NULL;
+	chunk=0;
+	offset=0;
+	pos=0;
+}
+
+wchar_t TextBuffer::const_iterator::operator*() const
+{
+	return (*buffer->chunks[chunk])[offset];
+}
+
+TextBuffer::const_iterator& TextBuffer::const_iterator::operator++()
+{
+	pos++;
+	offset++;
+	if (offset >= buffer->chunks[chunk]->size()) {
+		chunk++;
+		offset=0;
+	}
+	return *this;
+}
+
+/*!\brief Position des Zeichens, auf das der Iterator zeigt
+ */
+size_t TextBuffer::const_iterator::position() const
+{
+	return pos;
+}
+
+bool TextBuffer::const_iterator::operator==(const const_iterator& other) const
+{
+	return pos == other.pos;
+}
+
+bool TextBuffer::const_iterator::operator!=(const const_iterator& other) const
+{
+	return pos != other.pos;
+}
+
+TextBuffer::TextBuffer()
+{
+	total=0;
+}
+
+TextBuffer::TextBuffer(const WideString& text)
+{
+	total=0;
+	set(text);
+}
+
+TextBuffer& TextBuffer::operator=(const WideString& text)
+{
+	set(text);
+	return *this;
+}
+
+size_t TextBuffer::size() const
+{
+	return total;
+}
+
+bool TextBuffer::isEmpty() const
+{
+	return total == 0;
+}
+
+bool TextBuffer::notEmpty() const
+{
+	return total != 0;
+}
+
+void TextBuffer::clear()
+{
+	chunks.clear();
+	index.clear();
+	total=0;
+}
+
+void TextBuffer::set(const WideString& text)
+{
+	chunks.clear();
+	appendChunks(chunks, text.getPtr(), text.size());
+	total=text.size();
+	rebuildIndex();
+}
+
+/*!\brief Text in halb gefüllte Blöcke aufteilen
+ *
+ * \desc
+ * Die Blöcke werden nur zur Hälfte gefüllt, damit nachfolgende Eingaben an der gleichen
+ * Stelle nicht sofort wieder zu einer Teilung führen.
+ */
+void TextBuffer::appendChunks(std::vector<std::shared_ptr<Chunk> >& result, const wchar_t* text, size_t size) const
+{
+	size_t p=0;
+	while (p < size) {
+		size_t n=size - p;
+		if (n > TEXTBUFFER_CHUNK / 2) n=TEXTBUFFER_CHUNK / 2;
+		result.push_back(std::make_shared<Chunk>(text + p, text + p + n));
+		p+=n;
+	}
+}
+
+void TextBuffer::rebuildIndex()
+{
+	size_t n=chunks.size();
+	index.assign(n + 1, 0);
+	for (size_t i=1;i <= n;i++) {
+		index[i]+=chunks[i - 1]->size();
+		size_t parent=i + (i & (~i + 1));
+		if (parent <= n) index[parent]+=index[i];
+	}
+}
+
+void TextBuffer::addToIndex(size_t chunk, size_t added, size_t removed)
+{
+	for (size_t i=chunk + 1;i < index.size();i+=(i & (~i + 1))) {
+		index[i]=index[i] + added - removed;
+	}
+}
+
+/*!\brief Block einer Position suchen
+ *
+ * \param pos Position im Text
+ * \param offset Erhält die Position innerhalb des Blocks
+ * \return Index des Blocks. Ist \p pos die Position hinter dem letzten Zeichen, wird
+ * chunks.size() zurückgegeben.
+ */
+size_t TextBuffer::findChunk(size_t pos, size_t& offset) const
+{
+	size_t n=chunks.size();
+	size_t step=1;
+	while (step * 2 <= n) step*=2;
+	size_t i=0;
+	for (;step > 0;step/=2) {
+		if (i + step <= n && index[i + step] <= pos) {
+			i+=step;
+			pos-=index[i];
+		}
+	}
+	offset=pos;
+	return i;
+}
+
+/*!\brief Block zum Schreiben holen
+ *
+ * \desc
+ * Wird der Block noch von einer Kopie des Puffers verwendet, wird er vorher kopiert.
+ */
+TextBuffer::Chunk& TextBuffer::writableChunk(size_t chunk)
+{
+	if (chunks[chunk].use_count() > 1) chunks[chunk]=std::make_shared<Chunk>(*chunks[chunk]);
+	return *chunks[chunk];
+}
+
+/*!\brief Text einfügen
+ *
+ * \param pos Position, vor der eingefügt wird. Ist sie größer als der Text, wird
+ * angehängt.
+ * \param text Einzufügender Text
+ */
+void TextBuffer::insert(size_t pos, const WideString& text)
+{
+	size_t size=text.size();
+	if (!size) return;
+	if (pos > total) pos=total;
+	const wchar_t* ptr=text.getPtr();
+	if (chunks.empty()) {
+		set(text);
+		return;
+	}
+	size_t offset;
+	size_t c=findChunk(pos, offset);
+	if (c == chunks.size()) {
+		c--;
+		offset=chunks[c]->size();
+	}
+	total+=size;
+	if (chunks[c]->size() + size <= TEXTBUFFER_CHUNK) {
+		Chunk& chunk=writableChunk(c);
+		chunk.insert(chunk.begin() + offset, ptr, ptr + size);
+		addToIndex(c, size, 0);
+		return;
+	}
+	// Block läuft über und wird zusammen mit dem neuen Text neu aufgeteilt
+	const Chunk& old=*chunks[c];
+	Chunk joined;
+	joined.reserve(old.size() + size);
+	joined.insert(joined.end(), old.begin(), old.begin() + offset);
+	joined.insert(joined.end(), ptr, ptr + size);
+	joined.insert(joined.end(), old.begin() + offset, old.end());
+	std::vector<std::shared_ptr<Chunk> > parts;
+	appendChunks(parts, joined.data(), joined.size());
+	chunks.erase(chunks.begin() + c);
+	chunks.insert(chunks.begin() + c, parts.begin(), parts.end());
+	rebuildIndex();
+}
+
+/*!\brief Text löschen
+ *
+ * \param pos Position des ersten zu löschenden Zeichens
+ * \param count Anzahl Zeichen
+ */
+void TextBuffer::erase(size_t pos, size_t count)
+{
+	if (pos >= total) return;
+	if (count > total - pos) count=total - pos;
+	total-=count;
+	size_t offset;
+	size_t c=findChunk(pos, offset);
+	bool removed_chunks=false;
+	while (count > 0 && c < chunks.size()) {
+		size_t n=chunks[c]->size() - offset;
+		if (n > count) n=count;
+		count-=n;
+		if (offset == 0 && n == chunks[c]->size()) {
+			chunks.erase(chunks.begin() + c);
+			removed_chunks=true;
+		} else {
+			Chunk& chunk=writableChunk(c);
+			chunk.erase(chunk.begin() + offset, chunk.begin() + offset + n);
+			if (!removed_chunks) addToIndex(c, 0, n);
+			c++;
+			offset=0;
+		}
+	}
+	if (removed_chunks) rebuildIndex();
+}
+
+wchar_t TextBuffer::operator[](size_t pos) const
+{
+	if (pos >= total) return 0;
+	size_t offset;
+	size_t c=findChunk(pos, offset);
+	return (*chunks[c])[offset];
+}
+
+/*!\brief Teil des Textes als WideString
+ */
+WideString TextBuffer::mid(size_t pos, size_t count) const
+{
+	WideString result;
+	if (pos >= total) return result;
+	if (count > total - pos) count=total - pos;
+	result.reserve(count);
+	size_t offset;
+	size_t c=findChunk(pos, offset);
+	while (count > 0 && c < chunks.size()) {
+		size_t n=chunks[c]->size() - offset;
+		if (n > count) n=count;
+		result.append(chunks[c]->data() + offset, n);
+		count-=n;
+		c++;
+		offset=0;
+	}
+	return result;
+}
+
+/*!\brief Gesamter Text als WideString
+ */
+WideString TextBuffer::toWideString() const
+{
+	return mid(0, total);
+}
+
+bool TextBuffer::operator==(const TextBuffer& other) const
+{
+	if (total != other.total) return false;
+	if (chunks == other.chunks) return true;
+	const_iterator a=begin(), b=other.begin(), e=end();
+	for (;a != e;++a, ++b) {
+		if (*a != *b) return false;
+	}
+	return true;
+}
+
+bool TextBuffer::operator!=(const TextBuffer& other) const
+{
+	return !operator==(other);
+}
+
+TextBuffer::const_iterator TextBuffer::begin() const
+{
+	return at(0);
+}
+
+TextBuffer::const_iterator TextBuffer::end() const
+{
+	return at(total);
+}
+
+/*!\brief Iterator auf eine Position
+ *
+ * \desc
+ * Das Suchen des Blocks kostet O(log n), das Weiterzählen mit ++ danach O(1). Zum
+ * Durchlaufen eines Textabschnitts sollte daher ein Iterator verwendet werden statt
+ * operator[].
+ */
+TextBuffer::const_iterator TextBuffer::at(size_t pos) const
+{
+	const_iterator it;
+	if (pos > total) pos=total;
+	it.buffer=this;
+	it.pos=pos;
+	it.chunk=findChunk(pos, it.offset);
+	return it;
+}
+
+
+}	// EOF namespace ppltk
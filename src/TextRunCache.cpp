@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+
+#include "ppltk.h"
+
+
+namespace ppltk {
+
+using namespace ppl7;
+using namespace ppl7::grafix;
+
+/*!\class TextRunCache
+ * \brief Cache für gerenderte Texte
+ *
+ * \desc
+ * Labels und Buttons zeichnen bei jedem Neuzeichnen ihren Text, der sich meist gar
+ * nicht geändert hat. Der TextRunCache rendert einen Text pro Schriftart nur einmal
+ * als Maske und kopiert ihn danach mit Drawable::bltDiffuse in der gewünschten Farbe.
+ * Die Farbe ist daher nicht Teil des Schlüssels, ein Text wird in allen Farben aus
+ * der gleichen Maske gezeichnet.
+ * \par
+ * Der Speicher ist durch ein Budget begrenzt, bei dessen Überschreitung die am
+ * längsten nicht verwendeten Texte verworfen werden. Texte, deren Maske mehr als ein
+ * Sechzehntel des Budgets belegen würde, werden direkt mit Drawable::print gezeichnet.
+ * \par
+ * Alle Attribute des Fonts, die das Aussehen der Glyphen ändern, gehören zum Schlüssel.
+ * Rahmen und Schatten haben eigene Farben und lassen sich nicht aus einer einfarbigen
+ * Maske kopieren, ebenso wenig gedrehter Text. Solche Texte werden immer direkt
+ * gezeichnet. Die Orientierung spielt keine Rolle, da immer mit Font::TOP gezeichnet wird.
+ */
+
+// Bits für Key::flags
+#define TEXTRUN_BOLD		1
+#define TEXTRUN_ITALIC		2
+#define TEXTRUN_ANTIALIAS	4
+#define TEXTRUN_UNDERLINE	8
+
+bool TextRunCache::Key::operator<(const Key& other) const
+{
+	if (fontSize != other.fontSize) return fontSize < other.fontSize;
+	if (flags != other.flags) return flags < other.flags;
+	if (text != other.text) return text < other.text;
+	return fontName < other.fontName;
+}
+
+TextRunCache::TextRunCache()
+{
+	memory=0;
+	budget=4 * 1024 * 1024;
+	hitCount=0;
+	missCount=0;
+}
+
+/*!\brief Rand um die Maske
+ *
+ * \desc
+ * Font::measure liefert die Breite der Vorschübe. Kursive Glyphen ragen rechts darüber
+ * hinaus, manche auch links davor, Antialiasing kann einen Pixel daneben setzen. Die
+ * Maske ist daher auf beiden Seiten um diesen Rand breiter.
+ */
+static int maskPadding(const Font& font, const Size& s)
+{
+	if (font.italic()) return s.height / 4 + 1;
+	return 1;
+}
+
+const TextRunCache::Entry* TextRunCache::find(const Font& font, const String& text)
+{
+	if (font.drawBorder() || font.drawShadow() || font.rotation() != 0.0) return NULL;
+	Key key;
+	key.text=text;
+	key.fontName=font.name();
+	key.fontSize=font.size();
+	key.flags=0;
+	if (font.bold()) key.flags|=TEXTRUN_BOLD;
+	if (font.italic()) key.flags|=TEXTRUN_ITALIC;
+	if (font.antialias()) key.flags|=TEXTRUN_ANTIALIAS;
+	if (font.drawUnderline()) key.flags|=TEXTRUN_UNDERLINE;
+	std::map<Key, Entry>::iterator it=cache.find(key);
+	if (it != cache.end()) {
+		hitCount++;
+		lru.splice(lru.begin(), lru, it->second.lru);
+		return &it->second;
+	}
+	missCount++;
+	Size s=font.measure(text);
+	if (s.width <= 0 || s.height <= 0) return NULL;
+	int pad=maskPadding(font, s);
+	size_t bytes=(size_t)(s.width + 2 * pad) * s.height * 4;
+	if (bytes > budget / 16) return NULL;
+	evict(bytes);
+	Entry& e=cache[key];
+	e.size=s;
+	e.padding=pad;
+	// Weiß auf Schwarz, die Helligkeit wird beim Kopieren zur Deckkraft der Farbe
+	e.mask.create(s.width + 2 * pad, s.height, RGBFormat::A8R8G8B8);
+	e.mask.cls(Color(0, 0, 0, 255));
+	Font f=font;
+	f.setColor(Color(255, 255, 255, 255));
+	f.setOrientation(Font::TOP);
+	e.mask.print(f, pad, 0, text);
+	lru.push_front(key);
+	e.lru=lru.begin();
+	memory+=bytes;
+	return &e;
+}
+
+void TextRunCache::evict(size_t required)
+{
+	while (memory + required > budget && lru.size() > 0) {
+		std::map<Key, Entry>::iterator it=cache.find(lru.back());
+		memory-=(size_t)it->second.mask.width() * it->second.mask.height() * 4;
+		cache.erase(it);
+		lru.pop_back();
+	}
+}
+
+/*!\brief Größe eines Textes
+ *
+ * \desc
+ * Liefert das gleiche Ergebnis wie Font::measure, legt dabei aber gleich die Maske
+ * für einen folgenden Aufruf von print an.
+ */
+Size TextRunCache::measure(const Font& font, const String& text)
+{
+	const Entry* e=find(font, text);
+	if (e) return e->size;
+	return font.measure(text);
+}
+
+/*!\brief Text zeichnen
+ *
+ * \desc
+ * Zeichnet \p text wie Drawable::print mit der Orientierung Font::TOP in der Farbe
+ * des Fonts. Ist der Text noch nicht im Cache, wird er einmalig gerendert.
+ *
+ * \param draw Ziel
+ * \param font Schriftart und Farbe
+ * \param x X-Koordinate der linken oberen Ecke
+ * \param y Y-Koordinate der linken oberen Ecke
+ * \param text Text
+ */
+void TextRunCache::print(Drawable& draw, const Font& font, int x, int y, const String& text)
+{
+	if (text.isEmpty()) return;
+	const Entry* e=find(font, text);
+	if (e) {
+		draw.bltDiffuse(e->mask, x - e->padding, y, font.color());
+		return;
+	}
+	Font f=font;
+	f.setOrientation(Font::TOP);
+	draw.print(f, x, y, text);
+}
+
+void TextRunCache::clear()
+{
+	cache.clear();
+	lru.clear();
+	memory=0;
+}
+
+void TextRunCache::setMemoryBudget(size_t bytes)
+{
+	budget=bytes;
+	evict(0);
+}
+
+size_t TextRunCache::memoryBudget() const
+{
+	return budget;
+}
+
+size_t TextRunCache::memoryUsage() const
+{
+	return memory;
+}
+
+size_t TextRunCache::size() const
+{
+	return cache.size();
+}
+
+size_t TextRunCache::hits() const
+{
+	return hitCount;
+}
+
+size_t TextRunCache::misses() const
+{
+	return missCount;
+}
+
+
+}	// EOF namespace ppltk
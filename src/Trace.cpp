@@ -0,0 +1,194 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+
+#include "ppltk.h"
+#include "ppltk-trace.h"
+
+#include <stdio.h>
+#include <mutex>
+#include <vector>
+#include <chrono>
+
+namespace ppltk {
+namespace trace {
+
+#define TRACE_RING_SIZE 65536
+
+typedef struct {
+	const char* name;
+	uint64_t start;
+	uint64_t duration;
+} TRACE_EVENT;
+
+/*
+ * Ringpuffer eines Threads. Geschrieben wird nur vom eigenen Thread, head wird erst
+ * nach dem Eintrag hochgezählt, so dass ein lesender Thread nur fertige Einträge sieht.
+ * Die Puffer werden nie freigegeben, damit sie auch nach dem Ende eines Threads noch
+ * exportiert werden können.
+ */
+class Ring
+{
+public:
+	Ring(uint32_t tid)
+	{
+		this->tid=tid;
+		head.store(0);
+	}
+	uint32_t tid;
+	std::atomic<uint64_t> head;
+	TRACE_EVENT events[TRACE_RING_SIZE];
+};
+
+std::atomic<bool> enabled(false);
+static std::mutex rings_mutex;
+static std::vector<Ring*> rings;
+static thread_local Ring* my_ring=NULL;
+
+static uint64_t now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static Ring* getRing()
+{
+	if (my_ring) return my_ring;
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	my_ring=new Ring((uint32_t)rings.size() + 1);
+	rings.push_back(my_ring);
+	return my_ring;
+}
+
+void Zone::begin(const char* name)
+{
+	this->name=name;
+	start=now();
+}
+
+void Zone::end()
+{
+	uint64_t end=now();
+	Ring* ring=getRing();
+	uint64_t h=ring->head.load(std::memory_order_relaxed);
+	TRACE_EVENT& e=ring->events[h % TRACE_RING_SIZE];
+	e.name=name;
+	e.start=start;
+	e.duration=end - start;
+	ring->head.store(h + 1, std::memory_order_release);
+}
+
+void setEnabled(bool enable)
+{
+	enabled.store(enable);
+}
+
+bool isEnabled()
+{
+	return enabled.load();
+}
+
+/*!\brief Aufgezeichnete Zonen verwerfen
+ *
+ * \desc
+ * Sollte nur aufgerufen werden, während keine Zonen aufgezeichnet werden.
+ */
+void clear()
+{
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	for (size_t i=0;i < rings.size();i++) rings[i]->head.store(0);
+}
+
+/*!\brief Größe der Ringpuffer
+ *
+ * \return Anzahl Zonen, die pro Thread behalten werden. Ältere Einträge werden
+ * überschrieben.
+ */
+size_t bufferSize()
+{
+	return TRACE_RING_SIZE;
+}
+
+/*!\brief Aufzeichnung als Chrome-Trace speichern
+ *
+ * \desc
+ * Schreibt alle Zonen aller Threads als "Complete Events" im JSON-Format von
+ * chrome://tracing und Perfetto in die Datei \p filename. Die Zeiten werden relativ zur
+ * ältesten Zone in Mikrosekunden ausgegeben. Die Aufzeichnung darf dabei weiterlaufen,
+ * Einträge, die ein Thread während des Kopierens überschrieben haben kann, fehlen dann.
+ *
+ * \return Liefert \c false zurück, wenn die Datei nicht geschrieben werden konnte
+ */
+bool writeChromeTrace(const char* filename)
+{
+	FILE* fp=fopen(filename, "w");
+	if (!fp) return false;
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	std::vector<std::vector<TRACE_EVENT> > snapshot(rings.size());
+	uint64_t base=0;
+	for (size_t r=0;r < rings.size();r++) {
+		Ring* ring=rings[r];
+		std::vector<TRACE_EVENT>& events=snapshot[r];
+		uint64_t h=ring->head.load(std::memory_order_acquire);
+		uint64_t first=h > TRACE_RING_SIZE ? h - TRACE_RING_SIZE : 0;
+		events.reserve(h - first);
+		for (uint64_t i=first;i < h;i++) events.push_back(ring->events[i % TRACE_RING_SIZE]);
+		// Der Thread kann weiterschreiben. Einträge, deren Platz er beim Kopieren
+		// schon wieder belegt haben kann, werden verworfen.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t h2=ring->head.load(std::memory_order_relaxed);
+		if (h2 + 1 > first + TRACE_RING_SIZE) {
+			uint64_t torn=h2 + 1 - TRACE_RING_SIZE - first;
+			if (torn > events.size()) torn=events.size();
+			events.erase(events.begin(), events.begin() + torn);
+		}
+		for (size_t i=0;i < events.size();i++) {
+			if (base == 0 || events[i].start < base) base=events[i].start;
+		}
+	}
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool comma=false;
+	for (size_t r=0;r < rings.size();r++) {
+		const std::vector<TRACE_EVENT>& events=snapshot[r];
+		for (size_t i=0;i < events.size();i++) {
+			const TRACE_EVENT& e=events[i];
+			fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				comma ? ",\n" : "", e.name, rings[r]->tid,
+				(double)(e.start - base) / 1000.0, (double)e.duration / 1000.0);
+			comma=true;
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+	return true;
+}
+
+} // EOF namespace trace
+} // EOF namespace ppltk
@@ -31,6 +31,8 @@
 
 #include "ppltk.h"
 #include "ppltk-layout.h"
+#include "ppltk-trace.h"
+#include "RectHelper.h"
 
 
 namespace ppltk {
@@ -38,6 +40,16 @@ namespace ppltk {
 using namespace ppl7;
 using namespace ppl7::grafix;
 
+#define MAX_OCCLUDERS 8
+
+static size_t culled_paints=0;
+static size_t painted_widgets=0;
+static size_t skipped_widgets=0;
+static size_t layout_recalculations=0;
+static bool paint_profiling=false;
+static bool highlight_repaints=false;
+static std::map<String, FrameStats::PaintTime> paint_profile;
+
 Widget::Widget()
 {
 	parent=NULL;
@@ -48,7 +60,9 @@ Widget::Widget()
 	needsredraw=true;
 	transparent=false;
 	depug_paint=false;
+	stats_excluded=false;
 	child_needsredraw=false;
+	partial_redraw=false;
 	topMost=false;
 	modal=false;
 	deleteRequested=false;
@@ -57,6 +71,7 @@ Widget::Widget()
 	MinSize.width=0;
 	MinSize.height=0;
 	use_own_drawbuffer=false;
+	use_layer=false;
 	myName.set("unknown");
 }
 
@@ -70,7 +85,9 @@ Widget::Widget(int x, int y, int width, int height)
 	needsredraw=true;
 	transparent=false;
 	depug_paint=false;
+	stats_excluded=false;
 	child_needsredraw=false;
+	partial_redraw=false;
 	topMost=false;
 	modal=false;
 	deleteRequested=false;
@@ -79,12 +96,14 @@ Widget::Widget(int x, int y, int width, int height)
 	MinSize.width=0;
 	MinSize.height=0;
 	use_own_drawbuffer=false;
+	use_layer=false;
 	myName.set("unknown");
 	create(x, y, width, height);
 }
 
 Widget::~Widget()
 {
+	if (use_layer) Window::releaseLayer(this);
 	GetWindowManager()->unregisterWidget(this);
 	if (parent) parent->removeChild(this);
 	if (myLayout) delete myLayout;
@@ -108,6 +127,18 @@ void Widget::setDebugPaint(bool debug)
 	depug_paint=debug;
 }
 
+/*!\brief Widget aus der Frame-Statistik heraushalten
+ *
+ * \desc
+ * Ein Widget, das selbst Statistiken anzeigt, würde sonst bei jeder Aktualisierung
+ * seine eigene Zeichenarbeit messen. Ist \p flag \c true, zählt das Neuzeichnen des
+ * Widgets weder bei FrameStats::widgetsPainted noch in den Zeiten pro Widget-Typ.
+ */
+void Widget::setExcludedFromFrameStats(bool flag)
+{
+	stats_excluded=flag;
+}
+
 Layout* Widget::layout() const
 {
 	return myLayout;
@@ -123,7 +154,7 @@ void Widget::invalidateLayout()
 
 void Widget::updateDrawbuffer()
 {
-	if (!use_own_drawbuffer) return;
+	if (!use_own_drawbuffer && !use_layer) return;
 	if (drawbuffer.width() == s.width && drawbuffer.height() == s.height) return;
 	drawbuffer.create(s.width, s.height);
 	needsRedraw();
@@ -135,6 +166,40 @@ void Widget::setUseOwnDrawbuffer(bool enable)
 	updateDrawbuffer();
 }
 
+/*!\brief Widget in einem eigenen Layer darstellen
+ *
+ * \desc
+ * Ein Widget im Layer-Modus zeichnet sich und seine Childs in einen eigenen Puffer,
+ * den der Window-Manager als Textur vorhält und beim Präsentieren über den Inhalt des
+ * Fensters legt. Wird das Widget verschoben, in der Reihenfolge geändert oder ein- und
+ * ausgeblendet, muss daher weder das Widget selbst noch sein Parent neu gezeichnet
+ * werden, die Grafikkarte kopiert nur die Textur an die neue Position.
+ * \par
+ * Layer liegen immer über dem restlichen Inhalt des Fensters und werden nicht auf
+ * ihr Parent beschnitten. Der Modus eignet sich daher vor allem für Panels, Popups
+ * und ähnliche Widgets, die ohnehin oben liegen. Texturen von Layern, die längere Zeit
+ * nicht dargestellt wurden, werden freigegeben, sobald das mit
+ * Window::setLayerMemoryBudget eingestellte Budget überschritten ist.
+ *
+ * \param enable \c true schaltet den Layer-Modus ein, \c false wieder aus
+ */
+void Widget::setLayered(bool enable)
+{
+	if (use_layer == enable) return;
+	if (!enable) Window::releaseLayer(this);
+	use_layer=enable;
+	layer_damage=Rect();
+	updateDrawbuffer();
+	// Der Bereich im Fenster muss einmalig mit bzw. ohne das Widget neu gezeichnet werden
+	parentMustRedraw();
+	compositionChanged();
+}
+
+bool Widget::isLayered() const
+{
+	return use_layer;
+}
+
 void Widget::destroyChilds()
 {
 	std::list<Widget*>::iterator it;
@@ -194,6 +259,7 @@ void Widget::addChild(Widget* w)
 	childs.push_back(w);
 	w->parent=this;
 	childNeedsRedraw();
+	compositionChanged();
 	geometryChanged();
 }
 
@@ -204,20 +270,53 @@ void Widget::removeChild(Widget* w)
 	childs.remove(w);
 	w->parent=NULL;
 	needsRedraw();
+	compositionChanged();
 	geometryChanged();
 }
 
 void Widget::needsRedraw()
 {
-	if (needsredraw == true) return;
+	if (needsredraw == true && partial_redraw == false) return;
 	needsredraw=true;
+	partial_redraw=false;
 	child_needsredraw=true;
 	if (parent) {
-		if (transparent) parent->needsRedraw();
+		if (transparent && !use_layer) parent->needsRedraw();
 		else parent->childNeedsRedraw();
 	}
 }
 
+/*!\brief Teilbereich des Widgets neu zeichnen
+ *
+ * \desc
+ * Markiert nur den angegebenen Bereich des Widgets als neu zu zeichnen. Mehrere Aufrufe
+ * vor dem nächsten Zeichnen werden zu einem umschließenden Rechteck vereinigt. Beim
+ * Zeichnen wird das Rechteck als Clip-Bereich an paint(Drawable&, const Rect&) übergeben,
+ * und es werden nur die Childs neu gezeichnet, die davon überdeckt werden.
+ *
+ * \param r Rechteck in Koordinaten des Widgets
+ */
+void Widget::needsRedraw(const Rect& r)
+{
+	if (needsredraw == true && partial_redraw == false) return;
+	Rect clip=rect::intersect(r, Rect(0, 0, s.width, s.height));
+	if (rect::isEmpty(clip)) return;
+	if (needsredraw) {
+		damage_rect=rect::unite(damage_rect, clip);
+	} else {
+		damage_rect=clip;
+		needsredraw=true;
+		partial_redraw=true;
+	}
+	child_needsredraw=true;
+	if (parent) {
+		if (transparent && !use_layer) {
+			Point o=p + parent->myClientOffset.topLeft();
+			parent->needsRedraw(Rect(o.x + clip.left(), o.y + clip.top(), clip.width(), clip.height()));
+		} else parent->childNeedsRedraw();
+	}
+}
+
 void Widget::childNeedsRedraw()
 {
 	if (child_needsredraw) return;
@@ -228,6 +327,7 @@ void Widget::childNeedsRedraw()
 void Widget::parentMustRedraw()
 {
 	needsredraw=true;
+	partial_redraw=false;
 	if (parent) parent->parentMustRedraw();
 }
 
@@ -254,10 +354,14 @@ void Widget::toTop(Widget* w)
 	}
 	if (w == this) return;
 	childs.remove(w);
-	w->parent=NULL;
-	needsRedraw();
 	childs.push_front(w);
 	w->parent=this;
+	if (w->use_layer) {
+		// Nur die Reihenfolge der Texturen ändert sich
+		compositionChanged();
+		return;
+	}
+	needsRedraw();
 	childNeedsRedraw();
 }
 
@@ -436,7 +540,13 @@ void Widget::setVisible(bool flag)
 {
 	if (visible != flag) {
 		visible=flag;
-		needsRedraw();
+		if (use_layer) {
+			// Ein Layer wird nur nicht mehr dargestellt, ausstehendes Zeichnen wird nachgeholt
+			if (needsredraw && parent) parent->childNeedsRedraw();
+		} else {
+			needsRedraw();
+		}
+		compositionChanged();
 		geometryChanged();
 	}
 }
@@ -471,26 +581,30 @@ void Widget::create(int x, int y, int width, int height)
 void Widget::setX(int x)
 {
 	p.x=x;
-	parentMustRedraw();
+	if (use_layer) compositionChanged();
+	else parentMustRedraw();
 }
 
 void Widget::setY(int y)
 {
 	p.y=y;
-	parentMustRedraw();
+	if (use_layer) compositionChanged();
+	else parentMustRedraw();
 }
 
 void Widget::setPos(int x, int y)
 {
 	p.x=x;
 	p.y=y;
-	parentMustRedraw();
+	if (use_layer) compositionChanged();
+	else parentMustRedraw();
 }
 
 void Widget::setPos(const Point& p)
 {
 	this->p=p;
-	parentMustRedraw();
+	if (use_layer) compositionChanged();
+	else parentMustRedraw();
 }
 
 void Widget::sendResizeEvent()
@@ -553,7 +667,7 @@ void Widget::setClientOffset(int left, int top, int right, int bottom)
 
 Drawable Widget::drawable(const Drawable& parent) const
 {
-	if (use_own_drawbuffer) return drawbuffer;
+	if (use_own_drawbuffer || use_layer) return drawbuffer;
 	Drawable d;
 	d.copy(parent, p, s);
 	return d;
@@ -593,42 +707,276 @@ Size Widget::clientSize() const
 void Widget::draw(Drawable& d)
 {
 	if (!visible) return;
-	if (myLayout && myLayout->isValid == false) myLayout->recalculate();
-	if (needsredraw == false && child_needsredraw == false) return;
+	PPLTK_TRACE_ZONE("Widget::draw");
+	if (myLayout && myLayout->isValid == false) {
+		myLayout->recalculate();
+		layout_recalculations++;
+	}
+	if (needsredraw == false && child_needsredraw == false) {
+		skipped_widgets++;
+		return;
+	}
 	std::list<Widget*>::iterator it;
 	Drawable mycd=drawable(d);
 	Drawable cd;
+	Rect clip(0, 0, s.width, s.height);
+	bool partial=false;
 	if (needsredraw) {
-		paint(mycd);
+		if (partial_redraw) {
+			clip=expandRedrawClip(damage_rect);
+			if (rect::contains(clip, Rect(0, 0, s.width, s.height))) {
+				partial_redraw=false;
+				clip=Rect(0, 0, s.width, s.height);
+			}
+		}
+		PPLTK_TRACE_ZONE("Widget::paint");
+		if (paint_profiling && !stats_excluded) {
+			double start=ppl7::GetMicrotime();
+			paint(mycd, clip);
+			FrameStats::PaintTime& pt=paint_profile[widgetType()];
+			pt.count++;
+			pt.time+=(ppl7::GetMicrotime() - start) * 1000.0;
+		} else {
+			paint(mycd, clip);
+		}
+		if (!stats_excluded) painted_widgets++;
+		if (highlight_repaints) paintDebugFrame(mycd);
+		// paint kann auf komplettes Neuzeichnen umgeschaltet haben
+		if (partial_redraw) partial=true;
+		else clip=Rect(0, 0, s.width, s.height);
+		reportDamage(clip);
 		child_needsredraw=true;
 	}
 	if (child_needsredraw) {
-		// Jetzt die unten liegenden Childs
+		// Childs innerhalb des Clip-Bereichs wurden übermalt und müssen neu gezeichnet werden
+		Rect cclip(clip.left() - myClientOffset.x1, clip.top() - myClientOffset.y1, clip.width(), clip.height());
+		std::vector<char> occluded;
+		findOccludedChilds(occluded);
+		size_t i;
+		// Jetzt die unten liegenden Childs, dann die TopMost Childs
 		cd=clientDrawable(mycd);
-		for (it=childs.begin();it != childs.end();++it) {
-			Widget* child=*it;
-			if (child->topMost == false) {
-				if (needsredraw) child->redraw(cd);
-				else child->draw(cd);
-			}
-		}
-
-		// Dann die TopMost Childs
-		for (it=childs.begin();it != childs.end();++it) {
-			Widget* child=*it;
-			if (child->topMost == true) {
-				if (needsredraw) child->redraw(cd);
-				else child->draw(cd);
+		for (int pass=0;pass < 2;pass++) {
+			bool top=(pass == 1);
+			for (it=childs.begin(), i=0;it != childs.end();++it, i++) {
+				Widget* child=*it;
+				if (child->topMost != top) continue;
+				bool must_redraw=(needsredraw && (!partial || child->rect().intersects(cclip)));
+				if (occluded[i]) {
+					if (must_redraw || child->redrawRequired()) {
+						// Wird nachgeholt, sobald das Widget nicht mehr verdeckt ist
+						culled_paints++;
+						skipped_widgets++;
+						child->needsredraw=true;
+						child->partial_redraw=false;
+					}
+				} else if (must_redraw && !child->use_layer) {
+					if (partial && child->transparent) {
+						// Der Hintergrund wurde nur im Clip-Bereich neu gezeichnet
+						Rect cr=child->rect();
+						Rect r=rect::intersect(cr, cclip);
+						child->redraw(cd, Rect(r.left() - cr.left(), r.top() - cr.top(), r.width(), r.height()));
+					} else {
+						child->redraw(cd);
+					}
+				} else child->draw(cd);
 			}
 		}
 		child_needsredraw=false;
 	}
-	if (use_own_drawbuffer) {
+	if (use_own_drawbuffer && !use_layer) {
 		//printf("Blt Widget with own drawbuffer\n");
 		d.blt(drawbuffer, p.x, p.y);
+		reportDamage(Rect(0, 0, s.width, s.height));
 		if (parent) parent->markWidgetsAboveForRedraw(this);
 	}
 	needsredraw=false;
+	partial_redraw=false;
+}
+
+/*!\brief Clip-Bereich für ein teilweises Neuzeichnen bestimmen
+ *
+ * \desc
+ * Transparente Childs werden über den Hintergrund des Widgets gezeichnet und dürfen daher
+ * nur dort neu gezeichnet werden, wo vorher der Hintergrund neu gezeichnet wurde. Kann ein
+ * betroffenes transparentes Child nur komplett gezeichnet werden, wird der Clip-Bereich
+ * schon vor paint um das Child erweitert. Kann das Widget selbst nicht teilweise zeichnen,
+ * wird das ganze Widget zurückgegeben.
+ *
+ * \param r Neu zu zeichnender Bereich in Koordinaten des Widgets
+ */
+Rect Widget::expandRedrawClip(const Rect& r) const
+{
+	Rect full(0, 0, s.width, s.height);
+	if (!canPaintPartially()) return full;
+	Rect clip=rect::intersect(r, full);
+	std::list<Widget*>::const_iterator it;
+	bool changed=true;
+	while (changed && !rect::contains(clip, full)) {
+		changed=false;
+		Rect cclip(clip.left() - myClientOffset.x1, clip.top() - myClientOffset.y1, clip.width(), clip.height());
+		for (it=childs.begin();it != childs.end();++it) {
+			const Widget* child=*it;
+			if (child->visible == false || child->use_layer || child->transparent == false) continue;
+			Rect cr=child->rect();
+			Rect is=rect::intersect(cr, cclip);
+			if (rect::isEmpty(is)) continue;
+			Rect local(is.left() - cr.left(), is.top() - cr.top(), is.width(), is.height());
+			Rect need=child->expandRedrawClip(local);
+			if (rect::contains(local, need)) continue;
+			need=rect::intersect(Rect(need.left() + cr.left() + myClientOffset.x1,
+				need.top() + cr.top() + myClientOffset.y1, need.width(), need.height()), full);
+			if (rect::contains(clip, need)) continue;
+			clip=rect::unite(clip, need);
+			changed=true;
+		}
+	}
+	return clip;
+}
+
+/*!\brief Verdeckte Childs ermitteln
+ *
+ * \desc
+ * Geht die Childs von oben nach unten durch und merkt sich dabei die größten
+ * undurchsichtigen Widgets (siehe isOpaque). Ein Child, das vollständig innerhalb
+ * eines davon liegt, muss nicht gezeichnet werden.
+ *
+ * \param occluded Wird mit einem Flag pro Child in der Reihenfolge der Liste gefüllt
+ */
+void Widget::findOccludedChilds(std::vector<char>& occluded) const
+{
+	occluded.assign(childs.size(), 0);
+	if (childs.size() < 2) return;
+	Rect occluders[MAX_OCCLUDERS];
+	int area[MAX_OCCLUDERS];
+	int num=0;
+	std::list<Widget*>::const_reverse_iterator it;
+	for (int pass=0;pass < 2;pass++) {
+		bool top=(pass == 0);
+		size_t i=childs.size();
+		for (it=childs.rbegin();it != childs.rend();++it) {
+			i--;
+			const Widget* child=*it;
+			// Layer liegen nicht in der Oberfläche des Fensters
+			if (child->topMost != top || child->visible == false || child->use_layer) continue;
+			Rect r=child->rect();
+			for (int n=0;n < num;n++) {
+				if (rect::contains(occluders[n], r)) {
+					occluded[i]=1;
+					break;
+				}
+			}
+			if (occluded[i] || child->isOpaque() == false) continue;
+			int a=r.width() * r.height();
+			if (num < MAX_OCCLUDERS) {
+				occluders[num]=r;
+				area[num]=a;
+				num++;
+			} else {
+				int smallest=0;
+				for (int n=1;n < num;n++) if (area[n] < area[smallest]) smallest=n;
+				if (a > area[smallest]) {
+					occluders[smallest]=r;
+					area[smallest]=a;
+				}
+			}
+		}
+	}
+}
+
+size_t Widget::culledPaintCount()
+{
+	return culled_paints;
+}
+
+size_t Widget::paintedWidgetCount()
+{
+	return painted_widgets;
+}
+
+size_t Widget::skippedWidgetCount()
+{
+	return skipped_widgets;
+}
+
+size_t Widget::layoutRecalculationCount()
+{
+	return layout_recalculations;
+}
+
+/*!\brief Zeitmessung von paint einschalten
+ *
+ * \desc
+ * Ist die Zeitmessung eingeschaltet, misst draw die Dauer jedes paint-Aufrufs und
+ * summiert sie pro Widget-Typ auf. Die Werte werden mit takePaintProfile abgeholt.
+ */
+void Widget::setPaintProfiling(bool enable)
+{
+	paint_profiling=enable;
+	if (!enable) paint_profile.clear();
+}
+
+/*!\brief Gemessene paint-Zeiten abholen
+ *
+ * \desc
+ * Übergibt die seit dem letzten Aufruf gesammelten Zeiten pro Widget-Typ in
+ * \p profile und setzt die interne Sammlung zurück.
+ */
+void Widget::takePaintProfile(std::map<String, FrameStats::PaintTime>& profile)
+{
+	profile.clear();
+	profile.swap(paint_profile);
+}
+
+/*!\brief Neu gezeichnete Widgets markieren
+ *
+ * \desc
+ * Zeichnet um jedes Widget, das neu gezeichnet wird, den gleichen rot-weißen Rahmen
+ * wie setDebugPaint, unabhängig davon, ob die abgeleitete Klasse Widget::paint aufruft.
+ */
+void Widget::setHighlightRepaints(bool enable)
+{
+	highlight_repaints=enable;
+}
+
+void Widget::reportDamage(const Rect& r)
+{
+	// Position im Koordinatensystem des Layers oder des obersten Widgets (Fenster) bestimmen
+	if (use_layer) {
+		layer_damage=rect::unite(layer_damage, r);
+		return;
+	}
+	if (!parent) {
+		addDamageRect(r);
+		return;
+	}
+	Point o=p;
+	Widget* w=parent;
+	while (w->parent && !w->use_layer) {
+		o+=w->p + w->myClientOffset.topLeft();
+		w=w->parent;
+	}
+	o+=w->myClientOffset.topLeft();
+	Rect dr(o.x + r.left(), o.y + r.top(), r.width(), r.height());
+	if (w->use_layer) w->layer_damage=rect::unite(w->layer_damage, dr);
+	else w->addDamageRect(dr);
+}
+
+void Widget::addDamageRect(const Rect& r)
+{
+
+}
+
+/*!\brief Darstellung der Layer hat sich geändert
+ *
+ * \desc
+ * Wird aufgerufen, wenn ein Layer verschoben, ein- oder ausgeblendet oder Widgets
+ * hinzugefügt oder entfernt wurden. Die Benachrichtigung wird bis zum Fenster
+ * weitergereicht, das die Liste seiner Layer neu aufbaut und beim nächsten Frame
+ * präsentiert.
+ */
+void Widget::compositionChanged()
+{
+	if (parent) parent->compositionChanged();
 }
 
 void Widget::redraw(Drawable& d)
@@ -637,6 +985,24 @@ void Widget::redraw(Drawable& d)
 	draw(d);
 }
 
+/*!\brief Teilbereich während des Zeichnens des Parents neu zeichnen
+ *
+ * \desc
+ * Im Gegensatz zu needsRedraw(const Rect&) wird der Parent nicht benachrichtigt, da er
+ * gerade selbst gezeichnet wird.
+ */
+void Widget::redraw(Drawable& d, const Rect& clip)
+{
+	if (!needsredraw) {
+		damage_rect=clip;
+		needsredraw=true;
+		partial_redraw=true;
+	} else if (partial_redraw) {
+		damage_rect=rect::unite(damage_rect, clip);
+	}
+	draw(d);
+}
+
 void Widget::markWidgetsAboveForRedraw(Widget* widget)
 {
 	if (parent) parent->markWidgetsAboveForRedraw(this);
@@ -670,6 +1036,11 @@ void Widget::markWidgetsAboveForRedraw(Widget* widget)
 void Widget::paint(Drawable& draw)
 {
 	if (!depug_paint) return;
+	paintDebugFrame(draw);
+}
+
+void Widget::paintDebugFrame(Drawable& draw)
+{
 	int step;
 	Color red(255, 0, 0, 255), white(255, 255, 255, 255);
 	int y2=draw.height() - 1;
@@ -697,6 +1068,34 @@ void Widget::paint(Drawable& draw)
 	}
 }
 
+/*!\brief Teilbereich des Widgets zeichnen
+ *
+ * \desc
+ * Wird von draw aufgerufen. \p clip enthält den Bereich, der durch needsRedraw(const Rect&)
+ * als neu zu zeichnen markiert wurde, oder das ganze Widget. Widgets, die nur den
+ * Teilbereich aktualisieren können, überschreiben diese Funktion und canPaintPartially.
+ * Ob teilweise gezeichnet wird, steht vor dem Aufruf fest. Die Standard-Implementierung
+ * wird daher immer mit dem ganzen Widget aufgerufen und ruft paint(Drawable&) auf.
+ *
+ * \param draw Drawable des kompletten Widgets
+ * \param clip Neu zu zeichnender Bereich in Koordinaten des Widgets
+ */
+void Widget::paint(Drawable& draw, const Rect& clip)
+{
+	paint(draw);
+}
+
+/*!\brief Kann das Widget einen Teilbereich zeichnen?
+ *
+ * \desc
+ * Wird von draw vor dem Zeichnen abgefragt. Liefert ein Widget false, wird es bei
+ * needsRedraw(const Rect&) komplett neu gezeichnet.
+ */
+bool Widget::canPaintPartially() const
+{
+	return false;
+}
+
 /*
 Size Widget::preferedSize() const
 {
@@ -738,6 +1137,18 @@ String Widget::widgetType() const
 	return String("Widget");
 }
 
+/*!\brief Deckt das Widget seinen Bereich vollständig ab?
+ *
+ * \desc
+ * Liefert true zurück, wenn paint jeden Pixel des Widgets überschreibt. Darunter liegende
+ * Geschwister-Widgets, die komplett verdeckt sind, werden dann beim Zeichnen übersprungen.
+ * Die Standard-Implementierung liefert false.
+ */
+bool Widget::isOpaque() const
+{
+	return false;
+}
+
 bool Widget::isChildOf(Widget* other) const
 {
 	if (parent == other) return true;
@@ -30,6 +30,7 @@
 
 
 #include "ppltk.h"
+#include "RectHelper.h"
 
 
 namespace ppltk {
@@ -42,26 +43,54 @@ static void setWindowTitle(void* privatedata, const String& Title) {}
 static void setWindowIcon(void* privatedata, const Drawable& Icon) {}
 static void createSurface(void* privatedata) {}
 static void createTexture(void* privatedata) {}
-static Drawable lockWindowSurface(void* privatedata) { return Drawable(); }
-static void unlockWindowSurface(void* privatedata) {}
+static void getWindowSurfaceFormat(void* privatedata, Size& size, RGBFormat& format) {}
+static size_t uploadWindowSurface(void* privatedata, const Drawable& surface, const std::vector<Rect>& spans) { return 0; }
 static void drawWindowSurface(void* privatedata) {}
 static void* getRenderer(void* privatedata) { return NULL; }
 static void clearScreen(void* privatedata) {}
 static void presentScreen(void* privatedata) {}
+static size_t uploadLayer(void* privatedata, const void* layer, const Drawable& surface, const Rect& dirty) { return 0; }
+static void drawLayer(void* privatedata, const void* layer, const Rect& dest) {}
+static void releaseLayer(void* privatedata, const void* layer) {}
+
+// Ab dieser Anzahl getrennter Bereiche wird nur noch das umschließende Rechteck hochgeladen
+static const size_t MAX_DAMAGE_SPANS=16;
 
 static PRIV_WINDOW_FUNCTIONS defWmFunctions ={
 		setWindowTitle,
 		setWindowIcon,
 		createSurface,
 		createTexture,
-		lockWindowSurface,
-		unlockWindowSurface,
+		getWindowSurfaceFormat,
+		uploadWindowSurface,
 		drawWindowSurface,
 		getRenderer,
 		clearScreen,
-		presentScreen
+		presentScreen,
+		uploadLayer,
+		drawLayer,
+		releaseLayer
 };
 
+/*
+ * Texturen der Layer (siehe Widget::setLayered) aller Fenster. Die Liste ist nach
+ * der letzten Verwendung sortiert, vorne steht der zuletzt dargestellte Layer.
+ * Überschreitet der Speicherbedarf das Budget, werden Texturen von hinten freigegeben.
+ * Der Inhalt bleibt im Puffer des Widgets erhalten und wird bei Bedarf neu hochgeladen.
+ * Layer, die ein Fenster gerade darstellt (displayed), werden nie freigegeben.
+ */
+typedef struct {
+	Window* window;
+	const Widget* widget;
+	size_t bytes;
+	bool displayed;
+} LAYER_ENTRY;
+
+static std::list<LAYER_ENTRY> layer_lru;
+static std::map<const Widget*, std::list<LAYER_ENTRY>::iterator> layer_index;
+static size_t layer_memory=0;
+static size_t layer_budget=64 * 1024 * 1024;
+
 
 Window::DisplayMode::DisplayMode()
 {
@@ -79,6 +108,16 @@ Window::DisplayMode::DisplayMode(const ppl7::grafix::RGBFormat& format, int widt
 }
 
 
+Window::FrameStatistics::FrameStatistics()
+{
+	framesPresented=0;
+	framesSkipped=0;
+	frameTime=0.0;
+	averageFrameTime=0.0;
+	maxFrameTime=0.0;
+	fps=0;
+}
+
 Window::Window()
 {
 	const WidgetStyle& style=GetWidgetStyle();
@@ -91,11 +130,19 @@ Window::Window()
 	myBackground=style.windowBackgroundColor;
 	keyfocus=this;
 	uiSizeIsFixed=false;
+	myUploadedBytes=0;
+	myCulledPaints=0;
+	myFrameRateLimit=60;
+	myLastPresentTime=0.0;
+	myFpsTime=ppl7::GetMicrotime();
+	myFpsCount=0;
+	myCompositionChanged=false;
 }
 
 Window::~Window()
 {
 	if (wm != NULL && privateData != NULL) wm->destroyWindow(*this);
+	forgetLayers();
 }
 
 void Window::setWindowSize(int width, int height)
@@ -150,6 +197,9 @@ void* Window::getPrivateData()
  */
 void Window::setPrivateData(void* data, WindowManager* wm, PRIV_WINDOW_FUNCTIONS* fn)
 {
+	// Texturen der Layer gehören zum bisherigen Fenster des Window-Managers
+	forgetLayers();
+	myCompositionChanged=true;
 	privateData=data;
 	this->wm=wm;
 	if (fn == NULL) this->fn=&defWmFunctions;
@@ -251,12 +301,7 @@ String Window::widgetType() const
 
 void Window::drawWidgets()
 {
-	if (redrawRequired()) {
-		Drawable d=fn->lockWindowSurface(privateData);
-		draw(d);
-		fn->unlockWindowSurface(privateData);
-	}
-	fn->drawWindowSurface(privateData);
+	updateWindowSurface(false);
 }
 
 MouseState Window::getMouseState()
@@ -266,12 +311,462 @@ MouseState Window::getMouseState()
 
 void Window::redrawWidgets()
 {
+	updateWindowSurface(true);
+}
+
+/*!\brief Geänderte Widgets in die Fensteroberfläche zeichnen
+ *
+ * \desc
+ * Gemeinsame Implementierung von drawWidgets und redrawWidgets. Die Widgets werden
+ * in das Image des Fensters gezeichnet, das zwischen den Frames erhalten bleibt.
+ * Anschließend übergibt das Fenster die beschädigten Bereiche an den Window-Manager,
+ * der nur diese in seine Textur kopiert, und meldet die Statistik des Frames an den
+ * WindowManager (siehe WindowManager::frameStats).
+ * \par
+ * Hat sich die Größe oder das Farbformat der Oberfläche geändert, wird das Image neu
+ * angelegt und alles neu gezeichnet.
+ *
+ * \param redrawAll Wenn \c true, werden alle Widgets neu gezeichnet
+ */
+void Window::updateWindowSurface(bool redrawAll)
+{
+	myUploadedBytes=0;
+	myCulledPaints=0;
 	if (redrawRequired()) {
-		Drawable d=fn->lockWindowSurface(privateData);
-		redraw(d);
-		fn->unlockWindowSurface(privateData);
+		FrameStats stats;
+		double start=ppl7::GetMicrotime();
+		size_t culled=culledPaintCount();
+		size_t painted=paintedWidgetCount();
+		size_t skipped=skippedWidgetCount();
+		size_t layouts=layoutRecalculationCount();
+		Size size;
+		RGBFormat format;
+		fn->getWindowSurfaceFormat(privateData, size, format);
+		if (size.width > 0 && size.height > 0
+			&& (size.width != myWindowSurface.width() || size.height != myWindowSurface.height()
+				|| (int)format != (int)myWindowSurface.rgbformat())) {
+			myWindowSurface.create(size.width, size.height, format);
+			redrawAll=true;
+		}
+		myDamageRect=Rect();
+		myDamageSpans.clear();
+		if (redrawAll) redraw(myWindowSurface);
+		else draw(myWindowSurface);
+		myUploadedBytes=fn->uploadWindowSurface(privateData, myWindowSurface, myDamageSpans);
+		myUploadedBytes+=uploadLayers();
+		myCulledPaints=culledPaintCount() - culled;
+		if (wm) {
+			stats.widgetsPainted=paintedWidgetCount() - painted;
+			stats.widgetsSkipped=skippedWidgetCount() - skipped;
+			stats.layoutRecalculations=layoutRecalculationCount() - layouts;
+			stats.bytesUploaded=myUploadedBytes;
+			stats.drawTime=(ppl7::GetMicrotime() - start) * 1000.0;
+			if (wm->isFrameStatsEnabled()) takePaintProfile(stats.paintTime);
+			if (wm->finishFrame(stats)) myDrawStats=stats;
+		}
+	} else {
+		myUploadedBytes=uploadLayers();
 	}
 	fn->drawWindowSurface(privateData);
+	drawLayers();
+}
+
+void Window::compositionChanged()
+{
+	myCompositionChanged=true;
+}
+
+void Window::collectLayers(const Widget* w, std::vector<Widget*>& layers)
+{
+	// Gleiche Reihenfolge wie in Widget::draw
+	std::list<Widget*>::const_iterator it;
+	for (int pass=0;pass < 2;pass++) {
+		bool top=(pass == 1);
+		for (it=w->childs.begin();it != w->childs.end();++it) {
+			Widget* child=*it;
+			if (child->topMost != top || child->visible == false) continue;
+			if (child->use_layer) layers.push_back(child);
+			collectLayers(child, layers);
+		}
+	}
+}
+
+Point Window::layerPosition(const Widget* w) const
+{
+	Point o=w->p;
+	const Widget* parent=w->parent;
+	while (parent->parent) {
+		o+=parent->p + parent->myClientOffset.topLeft();
+		parent=parent->parent;
+	}
+	o+=parent->myClientOffset.topLeft();
+	return o;
+}
+
+/*!\brief Layer hochladen
+ *
+ * \desc
+ * Baut bei Bedarf die Liste der sichtbaren Layer neu auf und lädt von jedem Layer
+ * den seit dem letzten Frame neu gezeichneten Bereich in seine Textur. Layer ohne
+ * Textur, z.B. nach dem Freigeben durch das Speicherbudget, werden komplett
+ * hochgeladen.
+ *
+ * \return Anzahl hochgeladener Bytes
+ */
+size_t Window::uploadLayers()
+{
+	std::vector<Widget*>::const_iterator it;
+	if (myCompositionChanged) {
+		for (it=myLayers.begin();it != myLayers.end();++it) {
+			std::map<const Widget*, std::list<LAYER_ENTRY>::iterator>::iterator idx=layer_index.find(*it);
+			if (idx != layer_index.end() && idx->second->window == this) idx->second->displayed=false;
+		}
+		myLayers.clear();
+		collectLayers(this, myLayers);
+		myCompositionChanged=false;
+	}
+	if (myLayers.empty()) {
+		evictLayers();
+		return 0;
+	}
+	size_t bytes=0;
+	for (it=myLayers.begin();it != myLayers.end();++it) {
+		Widget* w=*it;
+		if (w->drawbuffer.isEmpty()) continue;
+		size_t size=(size_t)w->drawbuffer.width() * w->drawbuffer.height() * w->drawbuffer.bytesPerPixel();
+		Rect dirty=w->layer_damage;
+		std::map<const Widget*, std::list<LAYER_ENTRY>::iterator>::iterator idx=layer_index.find(w);
+		if (idx != layer_index.end() && (idx->second->window != this || idx->second->bytes != size)) {
+			releaseLayer(w);
+			idx=layer_index.end();
+		}
+		if (idx == layer_index.end()) {
+			LAYER_ENTRY e;
+			e.window=this;
+			e.widget=w;
+			e.bytes=size;
+			e.displayed=true;
+			layer_lru.push_front(e);
+			idx=layer_index.insert(std::make_pair((const Widget*)w, layer_lru.begin())).first;
+			layer_memory+=size;
+			dirty=Rect(0, 0, w->drawbuffer.width(), w->drawbuffer.height());
+		} else {
+			layer_lru.splice(layer_lru.begin(), layer_lru, idx->second);
+		}
+		idx->second->displayed=true;
+		if (dirty.width() > 0 && dirty.height() > 0) bytes+=fn->uploadLayer(privateData, w, w->drawbuffer, dirty);
+		w->layer_damage=Rect();
+	}
+	evictLayers();
+	return bytes;
+}
+
+void Window::drawLayers()
+{
+	std::vector<Widget*>::const_iterator it;
+	for (it=myLayers.begin();it != myLayers.end();++it) {
+		Widget* w=*it;
+		if (w->drawbuffer.isEmpty()) continue;
+		Point p=layerPosition(w);
+		fn->drawLayer(privateData, w, Rect(p.x, p.y, w->drawbuffer.width(), w->drawbuffer.height()));
+	}
+}
+
+void Window::releaseLayer(const Widget* w)
+{
+	std::map<const Widget*, std::list<LAYER_ENTRY>::iterator>::iterator idx=layer_index.find(w);
+	if (idx == layer_index.end()) return;
+	Window* window=idx->second->window;
+	if (window->privateData) window->fn->releaseLayer(window->privateData, w);
+	layer_memory-=idx->second->bytes;
+	layer_lru.erase(idx->second);
+	layer_index.erase(idx);
+}
+
+void Window::evictLayers()
+{
+	std::list<LAYER_ENTRY>::iterator it=layer_lru.end();
+	while (layer_memory > layer_budget && it != layer_lru.begin()) {
+		--it;
+		// Layer, die irgendein Fenster gerade darstellt, bleiben erhalten
+		if (it->displayed) continue;
+		std::list<LAYER_ENTRY>::iterator victim=it;
+		++it;
+		releaseLayer(victim->widget);
+	}
+}
+
+void Window::forgetLayers()
+{
+	// Die Texturen selbst gibt der Window-Manager mit dem Fenster frei
+	std::list<LAYER_ENTRY>::iterator it=layer_lru.begin();
+	while (it != layer_lru.end()) {
+		if (it->window == this) {
+			layer_memory-=it->bytes;
+			layer_index.erase(it->widget);
+			it=layer_lru.erase(it);
+		} else {
+			++it;
+		}
+	}
+	myLayers.clear();
+}
+
+/*!\brief Speicherbudget für Layer setzen
+ *
+ * \desc
+ * Legt fest, wieviel Speicher die Texturen aller Layer (siehe Widget::setLayered)
+ * zusammen belegen dürfen. Wird das Budget überschritten, werden die Texturen der am
+ * längsten nicht mehr dargestellten Layer freigegeben. Layer, die gerade dargestellt
+ * werden, bleiben immer erhalten. Voreingestellt sind 64 MB.
+ *
+ * \param bytes Budget in Bytes
+ */
+void Window::setLayerMemoryBudget(size_t bytes)
+{
+	layer_budget=bytes;
+	evictLayers();
+}
+
+size_t Window::layerMemoryBudget()
+{
+	return layer_budget;
+}
+
+size_t Window::layerMemoryUsage()
+{
+	return layer_memory;
+}
+
+static bool rectsTouch(const Rect& a, const Rect& b)
+{
+	if (b.left() > a.left() + a.width() || a.left() > b.left() + b.width()) return false;
+	if (b.top() > a.top() + a.height() || a.top() > b.top() + b.height()) return false;
+	return true;
+}
+
+/*!\brief Beschädigte Bereiche sammeln
+ *
+ * \desc
+ * Wird von Widget::draw für jedes neu gezeichnete Widget aufgerufen. Überlappende oder
+ * aneinander grenzende Rechtecke werden zusammengefasst, getrennte Bereiche bleiben
+ * getrennt, damit der Window-Manager nach dem Zeichnen nur die tatsächlich geänderten
+ * Teile in die Textur hochladen muss. Werden es mehr als MAX_DAMAGE_SPANS Bereiche,
+ * wird nur noch das umschließende Rechteck verwendet.
+ *
+ * \param r Rechteck in Fensterkoordinaten
+ */
+void Window::addDamageRect(const Rect& r)
+{
+	if (r.width() <= 0 || r.height() <= 0) return;
+	myDamageRect=rect::unite(myDamageRect, r);
+	Rect span=r;
+	std::vector<Rect>::iterator it=myDamageSpans.begin();
+	while (it != myDamageSpans.end()) {
+		if (rectsTouch(*it, span)) {
+			span=rect::unite(*it, span);
+			myDamageSpans.erase(it);
+			// Der vergrößerte Bereich kann weitere Bereiche berühren
+			it=myDamageSpans.begin();
+		} else {
+			++it;
+		}
+	}
+	myDamageSpans.push_back(span);
+	if (myDamageSpans.size() > MAX_DAMAGE_SPANS) {
+		myDamageSpans.clear();
+		myDamageSpans.push_back(myDamageRect);
+	}
+}
+
+/*!\brief Zuletzt neu gezeichneter Bereich
+ *
+ * \return Liefert das Rechteck zurück, das beim letzten Aufruf von drawWidgets oder
+ * redrawWidgets neu gezeichnet wurde
+ */
+const Rect& Window::damageRect() const
+{
+	return myDamageRect;
+}
+
+/*!\brief Einzelne neu gezeichnete Bereiche
+ *
+ * \return Liefert die getrennten Rechtecke zurück, die beim letzten Aufruf von
+ * drawWidgets oder redrawWidgets neu gezeichnet und hochgeladen wurden
+ */
+const std::vector<Rect>& Window::damageSpans() const
+{
+	return myDamageSpans;
+}
+
+/*!\brief Hochgeladene Bytes des letzten Frames
+ *
+ * \return Liefert die Anzahl Bytes zurück, die beim letzten Aufruf von drawWidgets
+ * oder redrawWidgets in die Textur des Fensters kopiert wurden
+ */
+size_t Window::uploadedBytes() const
+{
+	return myUploadedBytes;
+}
+
+/*!\brief Übersprungene Widgets des letzten Frames
+ *
+ * \return Liefert die Anzahl Widgets zurück, deren Zeichnen beim letzten Aufruf von
+ * drawWidgets oder redrawWidgets übersprungen wurde, weil sie komplett von einem
+ * undurchsichtigen Widget verdeckt waren
+ */
+size_t Window::culledPaints() const
+{
+	return myCulledPaints;
+}
+
+/*!\brief Oberfläche des Fensters
+ *
+ * \desc
+ * Die Widgets werden in dieses Image gezeichnet, bevor der Window-Manager die
+ * geänderten Bereiche in seine Textur kopiert. Es enthält daher immer den Inhalt
+ * des zuletzt gezeichneten Frames in UI-Auflösung.
+ * Layer (siehe Widget::setLayered) sind nicht enthalten, siehe dazu screenshot.
+ *
+ * \return Referenz auf das Image. Sie ist nur bis zum nächsten Zeichnen gültig,
+ * falls sich die Größe des Fensters ändert.
+ */
+const Image& Window::windowSurface() const
+{
+	return myWindowSurface;
+}
+
+/*!\brief Bildschirmfoto des Fensters
+ *
+ * \return Liefert eine Kopie des zuletzt gezeichneten Frames zurück, in die auch
+ * die Layer (siehe Widget::setLayered) hineinkopiert wurden
+ */
+Image Window::screenshot() const
+{
+	Image img(myWindowSurface);
+	std::vector<Widget*> layers;
+	collectLayers(this, layers);
+	std::vector<Widget*>::const_iterator it;
+	for (it=layers.begin();it != layers.end();++it) {
+		Widget* w=*it;
+		if (w->drawbuffer.isEmpty()) continue;
+		Point p=layerPosition(w);
+		img.bltAlpha(w->drawbuffer, p.x, p.y);
+	}
+	return img;
+}
+
+/*!\brief Frame zeichnen und präsentieren
+ *
+ * \desc
+ * Zeichnet alle geänderten Widgets und präsentiert das Ergebnis. Hat sich seit dem
+ * letzten Frame nichts geändert, wird weder der Bildschirm gelöscht, noch die Textur
+ * kopiert, noch präsentiert, und die Funktion kehrt sofort zurück. Der Aufrufer
+ * sollte dann auf das nächste Ereignis warten, wie es WindowManager::startEventLoop
+ * tut.
+ * \par
+ * Ist WaitVsync nicht gesetzt und würde der Frame die mit setFrameRateLimit
+ * eingestellte Bildrate überschreiten, wird er zurückgehalten. Die Funktion wartet
+ * nicht, sondern kehrt mit \c false zurück. Wann der Frame fällig ist, liefert
+ * nextFrameDelay, die Ereignisschleife wartet höchstens so lange auf Ereignisse.
+ *
+ * \param force Wenn \c true, wird auch ohne Änderungen und ohne Rücksicht auf die
+ * Bildrate präsentiert, z.B. nachdem das Fenster wieder sichtbar geworden ist
+ * \return Liefert \c true zurück, wenn ein Frame präsentiert wurde
+ */
+bool Window::renderFrame(bool force)
+{
+	double start=ppl7::GetMicrotime();
+	if (!force && !redrawRequired() && !myCompositionChanged) {
+		myFrameStats.framesSkipped++;
+		updateFps(start);
+		return false;
+	}
+	if (!force && nextFrameDelay() > 0.0) return false;
+	// Nach einer Pause beginnt die Messung der Bildrate neu
+	if (start - myLastPresentTime >= 1.0) {
+		myFpsCount=0;
+		myFpsTime=start;
+	}
+	fn->clearScreen(privateData);
+	drawWidgets();
+	fn->presentScreen(privateData);
+	double end=ppl7::GetMicrotime();
+	myLastPresentTime=end;
+
+	double ms=(end - start) * 1000.0;
+	myFrameStats.framesPresented++;
+	myFrameStats.frameTime=ms;
+	if (myFrameStats.framesPresented == 1) myFrameStats.averageFrameTime=ms;
+	else myFrameStats.averageFrameTime=myFrameStats.averageFrameTime * 0.9 + ms * 0.1;
+	if (ms > myFrameStats.maxFrameTime) myFrameStats.maxFrameTime=ms;
+	myFpsCount++;
+	updateFps(end);
+	return true;
+}
+
+void Window::updateFps(double now)
+{
+	if (now - myFpsTime < 1.0) return;
+	myFrameStats.fps=(int)((double)myFpsCount / (now - myFpsTime) + 0.5);
+	myFpsCount=0;
+	myFpsTime=now;
+}
+
+/*!\brief Wartezeit bis zum nächsten Frame
+ *
+ * \return Liefert die Zeit in Sekunden zurück, nach der renderFrame einen wegen
+ * setFrameRateLimit zurückgehaltenen Frame präsentiert, 0, wenn er schon fällig
+ * ist, oder -1, wenn kein Frame zurückgehalten wird
+ */
+double Window::nextFrameDelay() const
+{
+	if (myFrameRateLimit <= 0 || (windowFlags & WaitVsync) != 0) return -1.0;
+	if (!redrawRequired() && !myCompositionChanged) return -1.0;
+	double delay=myLastPresentTime + 1.0 / (double)myFrameRateLimit - ppl7::GetMicrotime();
+	if (delay < 0.0) return 0.0;
+	return delay;
+}
+
+/*!\brief Maximale Bildrate setzen
+ *
+ * \desc
+ * Begrenzt die Anzahl Frames pro Sekunde, die renderFrame präsentiert, sofern das
+ * Fenster ohne WaitVsync erstellt wurde. Mit Vsync bestimmt der Bildschirm die Rate.
+ *
+ * \param fps Frames pro Sekunde, 0 schaltet die Begrenzung ab
+ */
+void Window::setFrameRateLimit(int fps)
+{
+	if (fps < 0) fps=0;
+	myFrameRateLimit=fps;
+}
+
+int Window::frameRateLimit() const
+{
+	return myFrameRateLimit;
+}
+
+/*!\brief Statistik über die präsentierten Frames
+ *
+ * \return Liefert Anzahl präsentierter und übersprungener Frames, die Dauer des
+ * letzten Frames, einen gleitenden Mittelwert und die Spitze in Millisekunden sowie
+ * die Frames pro Sekunde zurück
+ */
+const Window::FrameStatistics& Window::frameStatistics() const
+{
+	return myFrameStats;
+}
+
+/*!\brief Statistik des zuletzt gezeichneten Frames dieses Fensters
+ *
+ * \desc
+ * Wie WindowManager::frameStats, aber nur für dieses Fenster. Frames ohne neu
+ * gezeichnete Widgets und ohne Layout-Berechnung ersetzen die Werte nicht.
+ */
+const FrameStats& Window::drawStatistics() const
+{
+	return myDrawStats;
 }
 
 void Window::paint(Drawable& draw)
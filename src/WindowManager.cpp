@@ -30,6 +30,7 @@
 
 
 #include "ppltk.h"
+#include "ppltk-trace.h"
 
 
 namespace ppltk {
@@ -66,6 +67,7 @@ WindowManager::WindowManager()
 	KeyboardFocus=NULL;
 	grabMouseWidget=NULL;
 	GameControllerFocus=NULL;
+	frameStatsEnabled=false;
 
 	ppl7::Resource* resources=GetPPLTKResource();
 	ppl7::grafix::Grafix* gfx=ppl7::grafix::GetGrafix();
@@ -84,6 +86,19 @@ WindowManager::~WindowManager()
 	if (wm == this) wm=NULL;
 }
 
+/*!\brief Wartende Ereignisschleife aufwecken
+ *
+ * \desc
+ * Kann aus jedem Thread aufgerufen werden, damit startEventLoop geänderte Widgets
+ * sofort zeichnet, statt auf das nächste Ereignis zu warten. Die Standard-Implementierung
+ * tut nichts, so dass abgeleitete Window-Manager ohne blockierende Schleife sie nicht
+ * überschreiben müssen.
+ */
+void WindowManager::wakeEventLoop()
+{
+
+}
+
 const WidgetStyle& WindowManager::getWidgetStyle() const
 {
 	return Style;
@@ -92,9 +107,31 @@ const WidgetStyle& WindowManager::getWidgetStyle() const
 void WindowManager::setWidgetStyle(const WidgetStyle& style)
 {
 	Style=style;
+	myChromeCache.clear();
 	updateButtonSymbols();
 }
 
+/*!\brief Cache für vorgezeichnete Widget-Hintergründe
+ *
+ * \desc
+ * Liefert den gemeinsamen ChromeCache aller Widgets zurück. Er wird bei jedem
+ * Aufruf von setWidgetStyle geleert.
+ */
+ChromeCache& WindowManager::chromeCache()
+{
+	return myChromeCache;
+}
+
+/*!\brief Cache für gerenderte Texte
+ *
+ * \desc
+ * Liefert den gemeinsamen TextRunCache aller Widgets zurück.
+ */
+TextRunCache& WindowManager::textRunCache()
+{
+	return myTextRunCache;
+}
+
 void WindowManager::updateButtonSymbols()
 {
 	Resource* res=GetPPLTKResource();
@@ -184,6 +221,7 @@ void WindowManager::deferedDeleteWidgets(Widget* widget)
 
 void WindowManager::dispatchMouseEvent(Window* window, MouseEvent& event)
 {
+	PPLTK_TRACE_ZONE("WindowManager::dispatchMouseEvent");
 	Widget* w;
 	//printf("WindowManager::dispatchMouseEvent\n");
 	//deferedDeleteWidgets(window);
@@ -375,5 +413,89 @@ Widget* WindowManager::getGameControllerFocus() const
 	return GameControllerFocus;
 }
 
+FrameStats::PaintTime::PaintTime()
+{
+	count=0;
+	time=0.0;
+}
+
+FrameStats::FrameStats()
+{
+	clear();
+}
+
+void FrameStats::clear()
+{
+	widgetsPainted=0;
+	widgetsSkipped=0;
+	bytesUploaded=0;
+	eventsDispatched=0;
+	layoutRecalculations=0;
+	eventTime=0.0;
+	drawTime=0.0;
+	paintTime.clear();
+}
+
+/*!\brief Statistik des letzten Frames
+ *
+ * \desc
+ * Liefert die Zähler des zuletzt gezeichneten Frames zurück: gezeichnete und
+ * übersprungene Widgets, hochgeladene Bytes, Layout-Neuberechnungen, die seit dem
+ * vorherigen Frame verarbeiteten Ereignisse sowie die Zeit in Millisekunden, die für
+ * Ereignisse und für das Zeichnen gebraucht wurde. Die Zeiten pro Widget-Typ werden nur
+ * gemessen, wenn die Statistik mit setFrameStatsEnabled eingeschaltet wurde.
+ * \par
+ * Bei mehreren Fenstern ist das der zuletzt gezeichnete Frame irgendeines Fensters.
+ * Die Werte eines bestimmten Fensters liefert Window::drawStatistics.
+ */
+const FrameStats& WindowManager::frameStats() const
+{
+	return lastFrameStats;
+}
+
+void WindowManager::setFrameStatsEnabled(bool enable)
+{
+	frameStatsEnabled=enable;
+	Widget::setPaintProfiling(enable);
+}
+
+bool WindowManager::isFrameStatsEnabled() const
+{
+	return frameStatsEnabled;
+}
+
+/*!\brief Frame abschließen
+ *
+ * \desc
+ * Wird von Window nach dem Zeichnen aufgerufen. Die seit dem letzten übernommenen
+ * Frame gesammelten Ereignis-Zähler werden in \p drawStats übernommen.
+ * Frames, in denen kein Widget neu gezeichnet und kein Layout berechnet wurde, etwa
+ * weil sich nur ein FrameStatsOverlay aktualisiert hat, ersetzen die über frameStats
+ * abrufbaren Werte nicht. Ihre Ereignisse werden weiter gesammelt und dem nächsten
+ * übernommenen Frame zugerechnet.
+ *
+ * \param drawStats Statistik des Fensters
+ * \return Liefert \c true zurück, wenn der Frame Arbeit enthielt und übernommen wurde
+ */
+bool WindowManager::finishFrame(FrameStats& drawStats)
+{
+	drawStats.eventsDispatched=currentFrameStats.eventsDispatched;
+	drawStats.eventTime=currentFrameStats.eventTime;
+	// Ereignisse ohne sichtbare Wirkung zählen zum nächsten übernommenen Frame
+	if (drawStats.widgetsPainted == 0 && drawStats.layoutRecalculations == 0) return false;
+	currentFrameStats.clear();
+	lastFrameStats=drawStats;
+	return true;
+}
+
+void WindowManager::countDispatchedEvent()
+{
+	currentFrameStats.eventsDispatched++;
+}
+
+void WindowManager::addEventTime(double ms)
+{
+	currentFrameStats.eventTime+=ms;
+}
 
 }	// EOF namespace ppltk
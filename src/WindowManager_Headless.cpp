@@ -0,0 +1,475 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+
+#include "ppltk.h"
+#include "ppltk-trace.h"
+
+namespace ppltk {
+
+using namespace ppl7;
+using namespace ppl7::grafix;
+
+/*
+ * Der Headless-WindowManager benötigt kein Videogerät. Fenster werden in ein Image
+ * im Hauptspeicher gezeichnet, Ereignisse werden über die send...-Funktionen
+ * synchron erzeugt und Timer laufen auf einer virtuellen Uhr, die mit advanceTime
+ * weitergestellt wird. Damit lassen sich Benchmarks und Tests ohne Display
+ * ausführen.
+ */
+
+typedef struct {
+	int width, height;
+	RGBFormat format;
+} HEADLESS_WINDOW_PRIVATE;
+
+static void headlessCreateSurface(void* privatedata)
+{
+	// Die Oberfläche gehört dem Window und wird beim nächsten Zeichnen angelegt
+}
+
+static void headlessSetWindowTitle(void* privatedata, const String& Title) {}
+static void headlessSetWindowIcon(void* privatedata, const Drawable& Icon) {}
+static void headlessCreateTexture(void* privatedata) {}
+
+static void headlessGetWindowSurfaceFormat(void* privatedata, Size& size, RGBFormat& format)
+{
+	HEADLESS_WINDOW_PRIVATE* priv = (HEADLESS_WINDOW_PRIVATE*)privatedata;
+	if (!priv) throw NullPointerException();
+	size.setSize(priv->width, priv->height);
+	format = priv->format;
+}
+
+static size_t headlessUploadWindowSurface(void* privatedata, const Drawable& surface, const std::vector<Rect>& spans)
+{
+	// Es gibt keine Textur, in die hochgeladen werden müsste
+	return 0;
+}
+
+static void headlessDrawWindowSurface(void* privatedata) {}
+static void* headlessGetRenderer(void* privatedata) { return NULL; }
+static void headlessClearScreen(void* privatedata) {}
+static void headlessPresentScreen(void* privatedata) {}
+// Layer werden nur für Window::screenshot in die Oberfläche kopiert
+static size_t headlessUploadLayer(void* privatedata, const void* layer, const Drawable& surface, const Rect& dirty) { return 0; }
+static void headlessDrawLayer(void* privatedata, const void* layer, const Rect& dest) {}
+static void headlessReleaseLayer(void* privatedata, const void* layer) {}
+
+static PRIV_WINDOW_FUNCTIONS headlessWmFunctions = {
+		headlessSetWindowTitle,
+		headlessSetWindowIcon,
+		headlessCreateSurface,
+		headlessCreateTexture,
+		headlessGetWindowSurfaceFormat,
+		headlessUploadWindowSurface,
+		headlessDrawWindowSurface,
+		headlessGetRenderer,
+		headlessClearScreen,
+		headlessPresentScreen,
+		headlessUploadLayer,
+		headlessDrawLayer,
+		headlessReleaseLayer
+};
+
+
+WindowManager_Headless::WindowManager_Headless(int width, int height)
+{
+	screenRGBFormat = RGBFormat::A8R8G8B8;
+	screenSize.setSize(width, height);
+	mouse.buttonMask = (MouseState::MouseButton)0;
+	mouse.button = (MouseState::MouseButton)0;
+	mouse.keyModifier = 0;
+	clock = 0;
+	nextTimerId = 1;
+}
+
+WindowManager_Headless::~WindowManager_Headless()
+{
+	while (windows.size() > 0) {
+		destroyWindow(*windows.front());
+	}
+}
+
+const Size& WindowManager_Headless::desktopResolution() const
+{
+	return screenSize;
+}
+
+const RGBFormat& WindowManager_Headless::desktopRGBFormat() const
+{
+	return screenRGBFormat;
+}
+
+void WindowManager_Headless::createWindow(Window& w)
+{
+	if (w.getPrivateData() != NULL) throw WindowAlreadyCreatedException();
+	Size windowSize = w.windowSize();
+	if (windowSize.width == 0 || windowSize.height == 0) {
+		windowSize = w.size();
+		w.setWindowSize(windowSize);
+	}
+	w.setSize(windowSize);
+	Size ui_size = w.uiSize();
+
+	HEADLESS_WINDOW_PRIVATE* priv = new HEADLESS_WINDOW_PRIVATE;
+	priv->format = RGBFormat::A8R8G8B8;
+	priv->width = ui_size.width;
+	priv->height = ui_size.height;
+	headlessCreateSurface(priv);
+	w.setPrivateData(priv, this, &headlessWmFunctions);
+	windows.push_back(&w);
+	w.needsRedraw();
+}
+
+void WindowManager_Headless::destroyWindow(Window& w)
+{
+	HEADLESS_WINDOW_PRIVATE* priv = (HEADLESS_WINDOW_PRIVATE*)w.getPrivateData();
+	if (!priv) return;
+	windows.remove(&w);
+	std::map<int, Timer>::iterator it = timers.begin();
+	while (it != timers.end()) {
+		if (it->second.clickWindow == &w) it = timers.erase(it);
+		else ++it;
+	}
+	delete priv;
+	w.setPrivateData(NULL, NULL, NULL);
+}
+
+void WindowManager_Headless::setWindowPosition(Window& w, int x, int y)
+{
+
+}
+
+void WindowManager_Headless::resizeWindow(Window& w, int width, int height)
+{
+	HEADLESS_WINDOW_PRIVATE* priv = (HEADLESS_WINDOW_PRIVATE*)w.getPrivateData();
+	if (!priv) return;
+	if (w.hasFixedUiSize()) return;
+	priv->width = width;
+	priv->height = height;
+	headlessCreateSurface(priv);
+	w.needsRedraw();
+}
+
+void WindowManager_Headless::setWindowDisplayMode(Window& w, const Window::DisplayMode& mode)
+{
+	HEADLESS_WINDOW_PRIVATE* priv = (HEADLESS_WINDOW_PRIVATE*)w.getPrivateData();
+	if (!priv) return;
+	w.setSize(mode.width, mode.height);
+	if (w.hasFixedUiSize()) return;
+	priv->width = mode.width;
+	priv->height = mode.height;
+	headlessCreateSurface(priv);
+	w.needsRedraw();
+}
+
+size_t WindowManager_Headless::numWindows()
+{
+	return windows.size();
+}
+
+void WindowManager_Headless::getMouseState(Point& p, int& buttonMask) const
+{
+	p = mouse.p;
+	buttonMask = (int)mouse.buttonMask;
+}
+
+MouseState WindowManager_Headless::getMouseState() const
+{
+	return mouse;
+}
+
+/*!\brief Ereignisschleife
+ *
+ * \desc
+ * Ohne Videogerät gibt es keine Quelle für Ereignisse, auf die gewartet werden
+ * könnte. Daher werden nur fällige Timer ausgeführt und alle geänderten Fenster
+ * gezeichnet, danach kehrt die Funktion zurück.
+ */
+void WindowManager_Headless::startEventLoop()
+{
+	handleEvents();
+	drawPendingWindows();
+}
+
+void WindowManager_Headless::drawPendingWindows()
+{
+	std::list<Window*>::iterator it;
+	for (it = windows.begin(); it != windows.end(); ++it) {
+		(*it)->renderFrame();
+	}
+}
+
+void WindowManager_Headless::handleEvents()
+{
+	PPLTK_TRACE_ZONE("WindowManager::handleEvents");
+	double start = ppl7::GetMicrotime();
+	advanceTime(0);
+	addEventTime((ppl7::GetMicrotime() - start) * 1000.0);
+}
+
+void WindowManager_Headless::wakeEventLoop()
+{
+
+}
+
+void WindowManager_Headless::startClickEvent(Window* win)
+{
+	Timer t;
+	t.widget = NULL;
+	t.clickWindow = win;
+	t.intervall = 0;
+	t.due = clock + getDoubleClickIntervall();
+	timers[nextTimerId++] = t;
+}
+
+int WindowManager_Headless::startTimer(Widget* w, int intervall)
+{
+	if (intervall < 1) intervall = 1;
+	Timer t;
+	t.widget = w;
+	t.clickWindow = NULL;
+	t.intervall = intervall;
+	t.due = clock + intervall;
+	int id = nextTimerId++;
+	timers[id] = t;
+	return id;
+}
+
+void WindowManager_Headless::removeTimer(int timer_id)
+{
+	timers.erase(timer_id);
+}
+
+/*!\brief Virtuelle Uhr
+ *
+ * \return Liefert die Zeit in Millisekunden zurück, um die die Uhr seit dem Erstellen
+ * des WindowManagers mit advanceTime weitergestellt wurde
+ */
+uint64_t WindowManager_Headless::currentTime() const
+{
+	return clock;
+}
+
+/*!\brief Virtuelle Uhr weiterstellen
+ *
+ * \desc
+ * Stellt die Uhr um \p ms Millisekunden vor und führt dabei alle fälligen Timer in
+ * zeitlicher Reihenfolge aus, einschließlich der verzögerten Klick-Ereignisse.
+ * Ein Timer, der mehrfach fällig wird, wird auch mehrfach ausgeführt.
+ *
+ * \param ms Millisekunden
+ */
+void WindowManager_Headless::advanceTime(int ms)
+{
+	uint64_t target = clock;
+	if (ms > 0) target += ms;
+	while (true) {
+		std::map<int, Timer>::iterator next = timers.end();
+		std::map<int, Timer>::iterator it;
+		for (it = timers.begin(); it != timers.end(); ++it) {
+			if (it->second.due > target) continue;
+			if (next == timers.end() || it->second.due < next->second.due) next = it;
+		}
+		if (next == timers.end()) break;
+		clock = next->second.due;
+		countDispatchedEvent();
+		Timer t = next->second;
+		if (t.clickWindow) {
+			timers.erase(next);
+			dispatchClickEvent(t.clickWindow);
+		} else {
+			next->second.due += t.intervall;
+			Event e;
+			e.setWidget(t.widget);
+			t.widget->timerEvent(&e);
+		}
+	}
+	clock = target;
+}
+
+const Image& WindowManager_Headless::windowSurface(Window& w) const
+{
+	if (!w.getPrivateData()) throw NoWindowException();
+	return w.windowSurface();
+}
+
+void WindowManager_Headless::sendMouseMove(Window& w, int x, int y)
+{
+	countDispatchedEvent();
+	MouseEvent ev;
+	ev.setType(Event::MouseMove);
+	mouse.p.setPoint(x, y);
+	ev.p = mouse.p;
+	ev.buttonMask = mouse.buttonMask;
+	ev.button = (MouseEvent::MouseButton)0;
+	ev.keyModifier = mouse.keyModifier;
+	dispatchMouseEvent(&w, ev);
+}
+
+void WindowManager_Headless::sendMouseDown(Window& w, int x, int y, MouseState::MouseButton button, int clicks)
+{
+	countDispatchedEvent();
+	MouseEvent ev;
+	ev.setType(Event::MouseDown);
+	mouse.p.setPoint(x, y);
+	mouse.buttonMask = (MouseState::MouseButton)(mouse.buttonMask | button);
+	ev.p = mouse.p;
+	ev.clicks = clicks;
+	ev.buttonMask = mouse.buttonMask;
+	ev.button = button;
+	ev.keyModifier = mouse.keyModifier;
+	dispatchMouseEvent(&w, ev);
+}
+
+void WindowManager_Headless::sendMouseUp(Window& w, int x, int y, MouseState::MouseButton button, int clicks)
+{
+	countDispatchedEvent();
+	MouseEvent ev;
+	ev.setType(Event::MouseUp);
+	mouse.p.setPoint(x, y);
+	mouse.buttonMask = (MouseState::MouseButton)(mouse.buttonMask & ~button);
+	ev.p = mouse.p;
+	ev.clicks = clicks;
+	ev.buttonMask = mouse.buttonMask;
+	ev.button = button;
+	ev.keyModifier = mouse.keyModifier;
+	dispatchMouseEvent(&w, ev);
+}
+
+/*!\brief Mausklick erzeugen
+ *
+ * \desc
+ * Erzeugt MouseDown und MouseUp an der gleichen Position und stellt die Uhr um das
+ * Doppelklick-Intervall weiter, so dass das Klick-Ereignis ausgeliefert wird.
+ */
+void WindowManager_Headless::sendMouseClick(Window& w, int x, int y, MouseState::MouseButton button)
+{
+	sendMouseDown(w, x, y, button, 1);
+	sendMouseUp(w, x, y, button, 1);
+	advanceTime(getDoubleClickIntervall());
+}
+
+void WindowManager_Headless::sendMouseWheel(Window& w, int x, int y)
+{
+	countDispatchedEvent();
+	MouseEvent ev;
+	ev.setType(Event::MouseWheel);
+	ev.p = mouse.p;
+	ev.buttonMask = mouse.buttonMask;
+	ev.button = (MouseEvent::MouseButton)0;
+	ev.keyModifier = mouse.keyModifier;
+	ev.wheel.setPoint(x, y);
+	dispatchMouseEvent(&w, ev);
+}
+
+void WindowManager_Headless::sendKeyDown(int key, int modifier, bool repeat)
+{
+	countDispatchedEvent();
+	mouse.keyModifier = modifier;
+	Widget* keyFocusWidget = getKeyboardFocus();
+	if (!keyFocusWidget) return;
+	KeyEvent kev;
+	kev.setWidget(keyFocusWidget);
+	kev.key = key;
+	kev.modifier = modifier;
+	kev.repeat = repeat;
+	keyFocusWidget->keyDownEvent(&kev);
+}
+
+void WindowManager_Headless::sendKeyUp(int key, int modifier)
+{
+	countDispatchedEvent();
+	mouse.keyModifier = modifier;
+	Widget* keyFocusWidget = getKeyboardFocus();
+	if (!keyFocusWidget) return;
+	KeyEvent kev;
+	kev.setWidget(keyFocusWidget);
+	kev.key = key;
+	kev.modifier = modifier;
+	kev.repeat = false;
+	keyFocusWidget->keyUpEvent(&kev);
+}
+
+void WindowManager_Headless::sendTextInput(const String& text)
+{
+	countDispatchedEvent();
+	Widget* keyFocusWidget = getKeyboardFocus();
+	if (!keyFocusWidget) return;
+	TextInputEvent te;
+	te.setWidget(keyFocusWidget);
+	te.text.set((const char*)text);
+	keyFocusWidget->textInputEvent(&te);
+}
+
+void WindowManager_Headless::sendResize(Window& w, int width, int height)
+{
+	countDispatchedEvent();
+	w.setWindowSize(width, height);
+	resizeWindow(w, width, height);
+	ResizeEvent e;
+	e.setWidget(&w);
+	e.width = width;
+	e.height = height;
+	w.resizeEvent(&e);
+}
+
+void WindowManager_Headless::sendClose(Window& w)
+{
+	countDispatchedEvent();
+	Event e(Event::Close);
+	e.setWidget(&w);
+	w.closeEvent(&e);
+}
+
+void WindowManager_Headless::sendQuit(Window& w)
+{
+	countDispatchedEvent();
+	Event e(Event::Quit);
+	e.setWidget(&w);
+	w.quitEvent(&e);
+}
+
+void WindowManager_Headless::setClipboardText(const ppl7::String& text)
+{
+	clipboard = text;
+}
+
+bool WindowManager_Headless::hasClipboardText() const
+{
+	return clipboard.notEmpty();
+}
+
+String WindowManager_Headless::getClipboardText() const
+{
+	return clipboard;
+}
+
+}	// EOF namespace ppltk
@@ -30,7 +30,9 @@
 
 
 #include "ppltk_config.h"
+#include <string.h>
 #include "ppltk.h"
+#include "ppltk-trace.h"
 #ifdef HAVE_SDL2
 #include <SDL2/SDL.h>
 #endif
@@ -44,6 +46,15 @@ using namespace ppl7::grafix;
 #ifdef HAVE_SDL2
 static WindowManager_SDL2* wm = NULL;
 
+// Maximale Wartezeit der Ereignisschleife in Millisekunden, falls sich Widgets
+// aus einem anderen Thread ändern, ohne wakeEventLoop aufzurufen
+static const Sint32 IDLE_WAKEUP_INTERVALL = 500;
+
+typedef struct {
+	SDL_Texture* tex;
+	int width, height;
+} SDL_LAYER;
+
 typedef struct {
 	SDL_DisplayMode* mode;
 	SDL_Window* win;
@@ -54,6 +65,8 @@ typedef struct {
 	bool scaleUi;
 	int window_width;
 	int window_height;
+	bool uploadAll;
+	std::map<const void*, SDL_LAYER>* layers;
 } SDL_WINDOW_PRIVATE;
 
 
@@ -251,7 +264,11 @@ static void sdlSetWindowIcon(void* privatedata, const Drawable& Icon)
 
 static void sdlCreateSurface(void* privatedata)
 {
-
+	SDL_WINDOW_PRIVATE* priv = (SDL_WINDOW_PRIVATE*)privatedata;
+	if (!priv) return;
+	// Die Oberfläche gehört dem Window. Eine neu angelegte Textur hat aber noch
+	// keinen definierten Inhalt und muss beim nächsten Upload komplett befüllt werden.
+	priv->uploadAll = true;
 }
 
 static void sdlCreateTexture(void* privatedata)
@@ -259,22 +276,56 @@ static void sdlCreateTexture(void* privatedata)
 
 }
 
-static Drawable sdlLockWindowSurface(void* privatedata)
+static void sdlGetWindowSurfaceFormat(void* privatedata, Size& size, RGBFormat& format)
 {
 	SDL_WINDOW_PRIVATE* priv = (SDL_WINDOW_PRIVATE*)privatedata;
 	if (!priv) throw NullPointerException();
-	void* pixels;
-	int pitch;
-	SDL_LockTexture(priv->gui, NULL, &pixels, &pitch);
-	//printf("gui texture gelockt: %d x %d\n", priv->width, priv->height);
-	return ppl7::grafix::Drawable(pixels, pitch, priv->width, priv->height, priv->format);
+	size.setSize(priv->width, priv->height);
+	format = priv->format;
+}
+
+static size_t sdlUploadSpan(SDL_Texture* tex, int width, int height, const Drawable& surface, const Rect& span)
+{
+	int x1 = span.left();
+	int y1 = span.top();
+	int x2 = x1 + span.width();
+	int y2 = y1 + span.height();
+	if (x1 < 0) x1 = 0;
+	if (y1 < 0) y1 = 0;
+	if (x2 > width) x2 = width;
+	if (y2 > height) y2 = height;
+	if (x2 > surface.width()) x2 = surface.width();
+	if (y2 > surface.height()) y2 = surface.height();
+	if (x2 <= x1 || y2 <= y1) return 0;
+	SDL_Rect r;
+	r.x = x1;
+	r.y = y1;
+	r.w = x2 - x1;
+	r.h = y2 - y1;
+	if (SDL_UpdateTexture(tex, &r, surface.adr(r.x, r.y), surface.pitch()) != 0) return 0;
+	return (size_t)r.w * surface.bytesPerPixel() * r.h;
 }
 
-static void sdlUnlockWindowSurface(void* privatedata)
+static size_t sdlUploadWindowSurface(void* privatedata, const Drawable& surface, const std::vector<Rect>& spans)
 {
+	PPLTK_TRACE_ZONE("sdlUploadWindowSurface");
 	SDL_WINDOW_PRIVATE* priv = (SDL_WINDOW_PRIVATE*)privatedata;
 	if (!priv) throw NullPointerException();
-	SDL_UnlockTexture(priv->gui);
+	if (!priv->gui || surface.isEmpty()) return 0;
+	// Der Inhalt einer mit SDL_LockTexture gesperrten Textur ist laut SDL undefiniert
+	// und darf nur beschrieben werden. Gezeichnet wird deshalb in das Image des Fensters,
+	// das zwischen den Frames erhalten bleibt, und nur die geänderten Bereiche werden
+	// mit SDL_UpdateTexture kopiert.
+	if (priv->uploadAll) {
+		priv->uploadAll = false;
+		return sdlUploadSpan(priv->gui, priv->width, priv->height, surface, Rect(0, 0, priv->width, priv->height));
+	}
+	size_t bytes = 0;
+	std::vector<Rect>::const_iterator it;
+	for (it = spans.begin();it != spans.end();++it) {
+		bytes += sdlUploadSpan(priv->gui, priv->width, priv->height, surface, *it);
+	}
+	return bytes;
 }
 
 static void getDestinationRect(SDL_WINDOW_PRIVATE* priv, SDL_Rect& dest)
@@ -330,6 +381,78 @@ static void sdlPresentScreen(void* privatedata)
 	SDL_RenderPresent(priv->renderer);
 }
 
+static size_t sdlUploadLayer(void* privatedata, const void* layer, const Drawable& surface, const Rect& dirty)
+{
+	SDL_WINDOW_PRIVATE* priv = (SDL_WINDOW_PRIVATE*)privatedata;
+	if (!priv) throw NullPointerException();
+	if (surface.isEmpty()) return 0;
+	if (!priv->layers) priv->layers = new std::map<const void*, SDL_LAYER>;
+	SDL_LAYER& l = (*priv->layers)[layer];
+	Rect r = dirty;
+	if (l.tex != NULL && (l.width != surface.width() || l.height != surface.height())) {
+		SDL_DestroyTexture(l.tex);
+		l.tex = NULL;
+	}
+	if (!l.tex) {
+		l.tex = SDL_CreateTexture(priv->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, surface.width(), surface.height());
+		if (!l.tex) {
+			priv->layers->erase(layer);
+			throw SurfaceCreateException("SDL_CreateTexture ERROR: %s", SDL_GetError());
+		}
+		SDL_SetTextureBlendMode(l.tex, SDL_BLENDMODE_BLEND);
+		l.width = surface.width();
+		l.height = surface.height();
+		r = Rect(0, 0, l.width, l.height);
+	}
+	return sdlUploadSpan(l.tex, l.width, l.height, surface, r);
+}
+
+static void sdlDrawLayer(void* privatedata, const void* layer, const Rect& dest)
+{
+	SDL_WINDOW_PRIVATE* priv = (SDL_WINDOW_PRIVATE*)privatedata;
+	if (!priv) throw NullPointerException();
+	if (!priv->layers) return;
+	std::map<const void*, SDL_LAYER>::const_iterator it = priv->layers->find(layer);
+	if (it == priv->layers->end()) return;
+	SDL_Rect r;
+	if (priv->scaleUi) {
+		SDL_Rect d;
+		getDestinationRect(priv, d);
+		r.x = d.x + dest.left() * d.w / priv->width;
+		r.y = d.y + dest.top() * d.h / priv->height;
+		r.w = dest.width() * d.w / priv->width;
+		r.h = dest.height() * d.h / priv->height;
+	}
+	else {
+		r.x = dest.left();
+		r.y = dest.top();
+		r.w = dest.width();
+		r.h = dest.height();
+	}
+	SDL_RenderCopy(priv->renderer, it->second.tex, NULL, &r);
+}
+
+static void sdlReleaseLayer(void* privatedata, const void* layer)
+{
+	SDL_WINDOW_PRIVATE* priv = (SDL_WINDOW_PRIVATE*)privatedata;
+	if (!priv || !priv->layers) return;
+	std::map<const void*, SDL_LAYER>::iterator it = priv->layers->find(layer);
+	if (it == priv->layers->end()) return;
+	SDL_DestroyTexture(it->second.tex);
+	priv->layers->erase(it);
+}
+
+static void sdlDestroyLayers(SDL_WINDOW_PRIVATE* priv)
+{
+	if (!priv->layers) return;
+	std::map<const void*, SDL_LAYER>::iterator it;
+	for (it = priv->layers->begin();it != priv->layers->end();++it) {
+		SDL_DestroyTexture(it->second.tex);
+	}
+	delete priv->layers;
+	priv->layers = NULL;
+}
+
 static int TranslateKeyModifierFromSDL(int sdl_key_modifier)
 {
 	int modifier = KeyEvent::KEYMOD_NONE;
@@ -379,12 +502,15 @@ static PRIV_WINDOW_FUNCTIONS sdlWmFunctions = {
 		sdlSetWindowIcon,
 		sdlCreateSurface,
 		sdlCreateTexture,
-		sdlLockWindowSurface,
-		sdlUnlockWindowSurface,
+		sdlGetWindowSurfaceFormat,
+		sdlUploadWindowSurface,
 		sdlDrawWindowSurface,
 		sdlGetRenderer,
 		sdlClearScreen,
-		sdlPresentScreen
+		sdlPresentScreen,
+		sdlUploadLayer,
+		sdlDrawLayer,
+		sdlReleaseLayer
 };
 
 #endif
@@ -528,9 +654,10 @@ void WindowManager_SDL2::createWindow(Window& w)
 	priv->format = RGBFormat::A8R8G8B8;
 	priv->width = ui_size.width;
 	priv->height = ui_size.height;
+	sdlCreateSurface(priv);
 	w.setPrivateData(priv, this, &sdlWmFunctions);
 	sdlSetWindowIcon(priv, w.windowIcon());
-	windows.add(&w);
+	windows.push_back(&w);
 #endif
 }
 
@@ -541,7 +668,8 @@ void WindowManager_SDL2::destroyWindow(Window& w)
 #else
 	SDL_WINDOW_PRIVATE* priv = (SDL_WINDOW_PRIVATE*)w.getPrivateData();
 	if (!priv) return;
-	windows.erase(&w);
+	windows.remove(&w);
+	sdlDestroyLayers(priv);
 	if (priv->gui) SDL_DestroyTexture(priv->gui);
 	if (priv->renderer) SDL_DestroyRenderer(priv->renderer);
 	if (priv->win) SDL_DestroyWindow(priv->win);
@@ -593,18 +721,73 @@ MouseState WindowManager_SDL2::getMouseState() const
 #endif
 }
 
+/*!\brief Ereignisschleife
+ *
+ * \desc
+ * Zeichnet alle Fenster neu, deren Widgets sich geändert haben, und blockiert danach
+ * in SDL_WaitEventTimeout, bis ein Ereignis eintrifft. Eingaben, Timer und
+ * WindowManager::wakeEventLoop wecken die Schleife auf, so dass ein untätiges UI
+ * praktisch keine CPU-Zeit verbraucht. Fenster ohne Änderungen werden weder
+ * gezeichnet noch präsentiert. Hält ein Fenster einen Frame wegen
+ * Window::setFrameRateLimit zurück, wartet die Schleife nur bis er fällig ist.
+ */
 void WindowManager_SDL2::startEventLoop()
 {
 #ifndef HAVE_SDL2
 	throw UnsupportedFeatureException("SDL2");
 #else
+	SDL_Event sdl_event;
 	while (numWindows() > 0) {
-		handleEvents();
-		ppl7::MSleep(5);
+		int timeout = drawPendingWindows();
+		if (SDL_WaitEventTimeout(&sdl_event, timeout)) {
+			PPLTK_TRACE_ZONE("WindowManager::handleEvents");
+			double start = ppl7::GetMicrotime();
+			DispatchEvent(&sdl_event);
+			addEventTime((ppl7::GetMicrotime() - start) * 1000.0);
+			handleEvents();
+		}
 	}
 #endif
 }
 
+/*!\brief Geänderte Fenster zeichnen
+ *
+ * \return Liefert die Zeit in Millisekunden zurück, die die Ereignisschleife
+ * höchstens warten darf, bis ein zurückgehaltener Frame fällig ist
+ */
+int WindowManager_SDL2::drawPendingWindows()
+{
+#ifndef HAVE_SDL2
+	throw UnsupportedFeatureException("SDL2");
+#else
+	int timeout = IDLE_WAKEUP_INTERVALL;
+	std::list<Window*>::iterator it;
+	for (it = windows.begin(); it != windows.end(); ++it) {
+		(*it)->renderFrame();
+		double delay = (*it)->nextFrameDelay();
+		if (delay >= 0.0) {
+			int ms = (int)(delay * 1000.0 + 0.999);
+			if (ms < timeout) timeout = ms;
+		}
+	}
+	return timeout;
+#endif
+}
+
+void WindowManager_SDL2::wakeEventLoop()
+{
+#ifndef HAVE_SDL2
+	throw UnsupportedFeatureException("SDL2");
+#else
+	SDL_Event event;
+	memset(&event, 0, sizeof(event));
+	event.type = SDL_USEREVENT;
+	event.user.type = SDL_USEREVENT;
+	event.user.code = 3;
+	SDL_PushEvent(&event);
+#endif
+}
+
 Window* WindowManager_SDL2::getWindow(uint32_t id)
 {
 #ifndef HAVE_SDL2
@@ -621,153 +804,167 @@ void WindowManager_SDL2::handleEvents()
 #ifndef HAVE_SDL2
 	throw UnsupportedFeatureException("SDL2");
 #else
+	PPLTK_TRACE_ZONE("WindowManager::handleEvents");
 	SDL_Event sdl_event;
+	double start = ppl7::GetMicrotime();
 	while (SDL_PollEvent(&sdl_event)) {		// Alle Events verarbeiten
-		//printf ("event vorhanden: %d\n",sdl_event.type);
-		switch (sdl_event.type) {
-		case SDL_QUIT:
-			DispatchQuitEvent(&sdl_event);
-			break;
-		case SDL_WINDOWEVENT:
-			DispatchWindowEvent(&sdl_event);
-			break;
-		case SDL_MOUSEMOTION:
-		case SDL_MOUSEBUTTONDOWN:
-		case SDL_MOUSEBUTTONUP:
-		case SDL_MOUSEWHEEL:
-			DispatchMouseEvent(&sdl_event);
-			break;
-		case SDL_KEYDOWN:
-			//ppl7::PrintDebug("SDL_KEYDOWN\n");
-			DispatchKeyEvent(&sdl_event);
-			break;
-
-		case SDL_KEYUP:
-			//ppl7::PrintDebug("SDL_KEYUP\n");
-			DispatchKeyEvent(&sdl_event);
-			break;
-		case SDL_TEXTINPUT:
-		{
-			//ppl7::PrintDebug("SDL_TEXTINPUT\n");
-			Widget* keyFocusWidget = getKeyboardFocus();
-			if (keyFocusWidget) {
-				SDL_TextInputEvent* event = (SDL_TextInputEvent*)&sdl_event;
-				TextInputEvent te;
-				te.text.set(event->text);
-				keyFocusWidget->textInputEvent(&te);
-
-			}
-
-			//printf ("Event: SDL_TEXTINPUT\n");
-			break;
-		}
-		case SDL_TEXTEDITING:
-			//printf("Event: SDL_TEXTEDITING\n");
-			break;
-		case SDL_USEREVENT:
-
-			if (sdl_event.user.code == 1) {	// ClickTimer
-				//printf("SDL_USEREVENT 1\n");
-				dispatchClickEvent((Window*)sdl_event.user.data1);
-			}
-			else if (sdl_event.user.code == 2) {	// TimerEvent
-				//printf("SDL_USEREVENT 2, windowid=%d\n", sdl_event.user.windowID);
-				Widget* w = (Widget*)sdl_event.user.data1;
-				Event e;
-				e.setWidget(w);
-				w->timerEvent(&e);
-			}
-			break;
-		case SDL_CONTROLLERAXISMOTION:
-		{
-			Widget* gcWidget = getGameControllerFocus();
-			if (gcWidget) {
-				SDL_ControllerAxisEvent* event = (SDL_ControllerAxisEvent*)&sdl_event;
-				GameControllerAxisEvent ev;
-				ev.setType(Event::GameControllerAxisMotion);
-				ev.setWidget(gcWidget);
-				ev.axis = event->axis;
-				ev.value = event->value;
-				gcWidget->gameControllerAxisMotionEvent(&ev);
-				//printf("Event: SDL_CONTROLLERAXISMOTION id=%d, axis=%d, value=%d\n", event->which, event->axis, event->value);
-
-			}
-			break;
+		DispatchEvent(&sdl_event);
+	}
+	addEventTime((ppl7::GetMicrotime() - start) * 1000.0);
+#endif
+}
+
+void WindowManager_SDL2::DispatchEvent(void* e)
+{
+#ifndef HAVE_SDL2
+	throw UnsupportedFeatureException("SDL2");
+#else
+	SDL_Event& sdl_event = *(SDL_Event*)e;
+	countDispatchedEvent();
+	//printf ("event vorhanden: %d\n",sdl_event.type);
+	switch (sdl_event.type) {
+	case SDL_QUIT:
+		DispatchQuitEvent(&sdl_event);
+		break;
+	case SDL_WINDOWEVENT:
+		DispatchWindowEvent(&sdl_event);
+		break;
+	case SDL_MOUSEMOTION:
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+	case SDL_MOUSEWHEEL:
+		DispatchMouseEvent(&sdl_event);
+		break;
+	case SDL_KEYDOWN:
+		//ppl7::PrintDebug("SDL_KEYDOWN\n");
+		DispatchKeyEvent(&sdl_event);
+		break;
+
+	case SDL_KEYUP:
+		//ppl7::PrintDebug("SDL_KEYUP\n");
+		DispatchKeyEvent(&sdl_event);
+		break;
+	case SDL_TEXTINPUT:
+	{
+		//ppl7::PrintDebug("SDL_TEXTINPUT\n");
+		Widget* keyFocusWidget = getKeyboardFocus();
+		if (keyFocusWidget) {
+			SDL_TextInputEvent* event = (SDL_TextInputEvent*)&sdl_event;
+			TextInputEvent te;
+			te.text.set(event->text);
+			keyFocusWidget->textInputEvent(&te);
+
 		}
-		case SDL_CONTROLLERBUTTONDOWN:
-		{
-			Widget* gcWidget = getGameControllerFocus();
-			if (gcWidget) {
-				SDL_ControllerButtonEvent* event = (SDL_ControllerButtonEvent*)&sdl_event;
-				GameControllerButtonEvent ev;
-				ev.setType(Event::GameControllerButtonDown);
-				ev.setWidget(gcWidget);
-				ev.button = event->button;
-				ev.state = event->state;
-				gcWidget->gameControllerButtonDownEvent(&ev);
-				//printf("Event: SDL_CONTROLLERBUTTONDOWN, id=%d, button=%d, state=%d\n", event->which, event->button, event->state);
-			}
-			break;
+
+		//printf ("Event: SDL_TEXTINPUT\n");
+		break;
+	}
+	case SDL_TEXTEDITING:
+		//printf("Event: SDL_TEXTEDITING\n");
+		break;
+	case SDL_USEREVENT:
+
+		if (sdl_event.user.code == 1) {	// ClickTimer
+			//printf("SDL_USEREVENT 1\n");
+			dispatchClickEvent((Window*)sdl_event.user.data1);
 		}
-		case SDL_CONTROLLERBUTTONUP:
-		{
-			Widget* gcWidget = getGameControllerFocus();
-			if (gcWidget) {
-				SDL_ControllerButtonEvent* event = (SDL_ControllerButtonEvent*)&sdl_event;
-				GameControllerButtonEvent ev;
-				ev.setType(Event::GameControllerButtonUp);
-				ev.setWidget(gcWidget);
-				ev.button = event->button;
-				ev.state = event->state;
-				gcWidget->gameControllerButtonUpEvent(&ev);
-				//printf("Event: SDL_CONTROLLERBUTTONDOWN, id=%d, button=%d, state=%d\n", event->which, event->button, event->state);
-			}
-			break;
+		else if (sdl_event.user.code == 2) {	// TimerEvent
+			//printf("SDL_USEREVENT 2, windowid=%d\n", sdl_event.user.windowID);
+			Widget* w = (Widget*)sdl_event.user.data1;
+			Event e;
+			e.setWidget(w);
+			w->timerEvent(&e);
 		}
-		case SDL_CONTROLLERDEVICEADDED:
-		{
-			Widget* gcWidget = getGameControllerFocus();
-			if (gcWidget) {
-				SDL_ControllerDeviceEvent* event = (SDL_ControllerDeviceEvent*)&sdl_event;
-				GameControllerEvent ev;
-				ev.setType(Event::GameControllerButtonUp);
-				ev.setWidget(gcWidget);
-				ev.which = event->which;
-				gcWidget->gameControllerDeviceAdded(&ev);
-			}
+		break;
+	case SDL_CONTROLLERAXISMOTION:
+	{
+		Widget* gcWidget = getGameControllerFocus();
+		if (gcWidget) {
+			SDL_ControllerAxisEvent* event = (SDL_ControllerAxisEvent*)&sdl_event;
+			GameControllerAxisEvent ev;
+			ev.setType(Event::GameControllerAxisMotion);
+			ev.setWidget(gcWidget);
+			ev.axis = event->axis;
+			ev.value = event->value;
+			gcWidget->gameControllerAxisMotionEvent(&ev);
+			//printf("Event: SDL_CONTROLLERAXISMOTION id=%d, axis=%d, value=%d\n", event->which, event->axis, event->value);
 
 		}
 		break;
-		case SDL_CONTROLLERDEVICEREMOVED:
-		{
-			Widget* gcWidget = getGameControllerFocus();
-			if (gcWidget) {
-				SDL_ControllerDeviceEvent* event = (SDL_ControllerDeviceEvent*)&sdl_event;
-				GameControllerEvent ev;
-				ev.setType(Event::GameControllerButtonUp);
-				ev.setWidget(gcWidget);
-				ev.which = event->which;
-				gcWidget->gameControllerDeviceRemoved(&ev);
-			}
+	}
+	case SDL_CONTROLLERBUTTONDOWN:
+	{
+		Widget* gcWidget = getGameControllerFocus();
+		if (gcWidget) {
+			SDL_ControllerButtonEvent* event = (SDL_ControllerButtonEvent*)&sdl_event;
+			GameControllerButtonEvent ev;
+			ev.setType(Event::GameControllerButtonDown);
+			ev.setWidget(gcWidget);
+			ev.button = event->button;
+			ev.state = event->state;
+			gcWidget->gameControllerButtonDownEvent(&ev);
+			//printf("Event: SDL_CONTROLLERBUTTONDOWN, id=%d, button=%d, state=%d\n", event->which, event->button, event->state);
 		}
 		break;
-
-		case SDL_DROPFILE:
-		{
-			//ppl7::PrintDebug("SDL_DROPFILE\n");
-			DropEvent ev;
-			ev.setType(Event::DropFileEvent);
-			ev.text.set(sdl_event.drop.file);
-			//Window* w=getWindow(sdl_event.window.windowID);
-			if (!lastWindowEnterEvent) return;
-			//ppl7::PrintDebug("OK\n");
-			SDL_free(sdl_event.drop.file);
-			lastWindowEnterEvent->dropEvent(&ev);
+	}
+	case SDL_CONTROLLERBUTTONUP:
+	{
+		Widget* gcWidget = getGameControllerFocus();
+		if (gcWidget) {
+			SDL_ControllerButtonEvent* event = (SDL_ControllerButtonEvent*)&sdl_event;
+			GameControllerButtonEvent ev;
+			ev.setType(Event::GameControllerButtonUp);
+			ev.setWidget(gcWidget);
+			ev.button = event->button;
+			ev.state = event->state;
+			gcWidget->gameControllerButtonUpEvent(&ev);
+			//printf("Event: SDL_CONTROLLERBUTTONDOWN, id=%d, button=%d, state=%d\n", event->which, event->button, event->state);
 		}
 		break;
+	}
+	case SDL_CONTROLLERDEVICEADDED:
+	{
+		Widget* gcWidget = getGameControllerFocus();
+		if (gcWidget) {
+			SDL_ControllerDeviceEvent* event = (SDL_ControllerDeviceEvent*)&sdl_event;
+			GameControllerEvent ev;
+			ev.setType(Event::GameControllerButtonUp);
+			ev.setWidget(gcWidget);
+			ev.which = event->which;
+			gcWidget->gameControllerDeviceAdded(&ev);
 		}
 
 	}
+	break;
+	case SDL_CONTROLLERDEVICEREMOVED:
+	{
+		Widget* gcWidget = getGameControllerFocus();
+		if (gcWidget) {
+			SDL_ControllerDeviceEvent* event = (SDL_ControllerDeviceEvent*)&sdl_event;
+			GameControllerEvent ev;
+			ev.setType(Event::GameControllerButtonUp);
+			ev.setWidget(gcWidget);
+			ev.which = event->which;
+			gcWidget->gameControllerDeviceRemoved(&ev);
+		}
+	}
+	break;
+
+	case SDL_DROPFILE:
+	{
+		//ppl7::PrintDebug("SDL_DROPFILE\n");
+		DropEvent ev;
+		ev.setType(Event::DropFileEvent);
+		ev.text.set(sdl_event.drop.file);
+		//Window* w=getWindow(sdl_event.window.windowID);
+		if (!lastWindowEnterEvent) return;
+		//ppl7::PrintDebug("OK\n");
+		SDL_free(sdl_event.drop.file);
+		lastWindowEnterEvent->dropEvent(&ev);
+	}
+	break;
+	}
+
 #endif
 }
 
@@ -799,20 +996,14 @@ void WindowManager_SDL2::DispatchWindowEvent(void* e)
 	switch (event->window.event) {
 	case SDL_WINDOWEVENT_SHOWN:
 		//printf("Window %d shown", event->window.windowID);
-		w->clearScreen();
-		w->drawWidgets();
-		w->presentScreen();
+		w->renderFrame(true);
 		break;
 	case SDL_WINDOWEVENT_HIDDEN:
 		//fprintf(stderr, "Window %d hidden", event->window.windowID);
 		break;
 	case SDL_WINDOWEVENT_EXPOSED:
 		//fprintf(stderr, "Window %d exposed", event->window.windowID);
-		/*
-		w->clearScreen();
-		w->drawWidgets();
-		w->presentScreen();
-		*/
+		w->renderFrame(true);
 		break;
 	case SDL_WINDOWEVENT_MOVED:
 		//fprintf(stderr, "Window %d moved to %d,%d",
@@ -1293,6 +1484,9 @@ void WindowManager_SDL2::setWindowDisplayMode(Window& w, const Window::DisplayMo
 		free(priv);
 		throw WindowCreateException("SDL_SetTextureBlendMode ERROR: %s", e);
 	}
+	priv->width = w.width();
+	priv->height = w.height();
+	sdlCreateSurface(priv);
 	w.needsRedraw();
 #endif
 }
@@ -1321,6 +1515,7 @@ void WindowManager_SDL2::resizeWindow(Window& w, int width, int height)
 	}
 	priv->width = width;
 	priv->height = height;
+	sdlCreateSurface(priv);
 	if (SDL_SetTextureBlendMode(priv->gui, SDL_BLENDMODE_BLEND) != 0) {
 		const char* e = SDL_GetError();
 		throw WindowCreateException("SDL_SetTextureBlendMode ERROR: %s", e);
@@ -31,6 +31,7 @@
 
 #include "ppltk.h"
 #include "ppltk-layout.h"
+#include "ppltk-trace.h"
 
 namespace ppltk {
 
@@ -82,6 +83,7 @@ void Layout::invalidate()
 
 void Layout::recalculate()
 {
+	PPLTK_TRACE_ZONE("Layout::recalculate");
 	update();
 	isValid=true;
 }
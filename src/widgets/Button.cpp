@@ -226,7 +226,13 @@ Size Button::contentSize() const
 }
 */
 
-void Button::paint(Drawable& draw)
+/*!\brief Hintergrund und Rahmen zeichnen
+ *
+ * \desc
+ * Der Hintergrund hängt nur von Größe, Hintergrundfarbe und Zustand ab und wird
+ * deshalb von paint über den ChromeCache des Window-Managers wiederverwendet.
+ */
+void Button::paintChrome(Drawable& draw)
 {
 	Color light=background * 1.8f;
 	Color shadow=background * 0.4f;
@@ -235,8 +241,8 @@ void Button::paint(Drawable& draw)
 	Color shade3=background * 0.90f;
 	Color shade4=background * 0.85f;
 
-	int w=width() - 1;
-	int h=height() - 1;
+	int w=draw.width() - 1;
+	int h=draw.height() - 1;
 	//draw.cls(background);
 
 	if (isDown) {
@@ -256,21 +262,36 @@ void Button::paint(Drawable& draw)
 	draw.colorGradient(r1, shade1, shade2, 1);
 	draw.colorGradient(r2, shade3, shade4, 1);
 
-	int x=0;
-	int y=0;
 	if (isDown) {
 		draw.line(0, 0, w, 0, shadow);
 		draw.line(0, 0, 0, h, shadow);
 		draw.line(0, h, w, h, light);
 		draw.line(w, 0, w, h, light);
-		x++;
-		y++;
 	} else {
 		draw.line(0, 0, w, 0, light);
 		draw.line(0, 0, 0, h, light);
 		draw.line(0, h, w, h, shadow);
 		draw.line(w, 0, w, h, shadow);
 	}
+}
+
+void Button::paint(Drawable& draw)
+{
+	bool created;
+	ChromeCache::Key key("Button", draw.size(), isDown, background);
+	Drawable* chrome=GetWindowManager()->chromeCache().lookup(key, created);
+	if (!chrome) paintChrome(draw);
+	else {
+		if (created) paintChrome(*chrome);
+		draw.blt(*chrome);
+	}
+
+	int x=0;
+	int y=0;
+	if (isDown) {
+		x++;
+		y++;
+	}
 	Drawable d=clientDrawable(draw);
 	if (Icon.isEmpty() == false) {
 		int icon_x=x + 2;
@@ -285,8 +306,9 @@ void Button::paint(Drawable& draw)
 		else myFont.setColor(Color::getBlendedf(background, foreground, 0.5f));
 		myFont.setOrientation(Font::TOP);
 
-		Size s=myFont.measure(Text);
-		d.print(myFont, x, y + ((d.height() - s.height) >> 1), Text);
+		TextRunCache& cache=GetWindowManager()->textRunCache();
+		Size s=cache.measure(myFont, Text);
+		cache.print(d, myFont, x, y + ((d.height() - s.height) >> 1), Text);
 	}
 
 }
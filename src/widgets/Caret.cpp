@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "ppltk.h"
+#include "../RectHelper.h"
+
+
+namespace ppltk {
+
+using namespace ppl7;
+using namespace ppl7::grafix;
+
+/*!\class Caret
+ * \brief Blinkender Text-Cursor
+ *
+ * \desc
+ * Position, Farbe und Blinkzustand des Cursors von LineInput und TextEdit. Das
+ * Eingabefeld zeichnet den Cursor selbst in paint und markiert bei Änderungen mit
+ * needsRedraw(const Rect&) nur den Bereich des Cursors als neu zu zeichnen. Dadurch
+ * wird der Cursor wie der Rest des Eingabefelds von Parents und darüberliegenden
+ * Widgets verdeckt.
+ */
+
+Caret::Caret()
+{
+	lit=false;
+}
+
+const Color& Caret::color() const
+{
+	return myColor;
+}
+
+void Caret::setColor(const Color& c)
+{
+	myColor=c;
+}
+
+bool Caret::isLit() const
+{
+	return lit;
+}
+
+/*!\brief Position im Client-Bereich des Eingabefelds
+ */
+const Rect& Caret::rect() const
+{
+	return myRect;
+}
+
+/*!\brief Position und Blinkzustand setzen
+ *
+ * \desc
+ * Setzt Position, Größe und Zustand des Cursors in Client-Koordinaten des Eingabefelds.
+ *
+ * \param damage Erhält den Bereich, der neu gezeichnet werden muss, in Client-Koordinaten
+ * \return true, wenn sich etwas geändert hat
+ */
+bool Caret::update(int x, int y, int width, int height, bool lit, Rect& damage)
+{
+	Rect r(x, y, width, height);
+	if (lit == this->lit && (!lit || (r.left() == myRect.left() && r.top() == myRect.top()
+		&& r.width() == myRect.width() && r.height() == myRect.height()))) {
+		myRect=r;
+		return false;
+	}
+	damage=Rect();
+	if (this->lit) damage=myRect;
+	if (lit) damage=rect::unite(damage, r);
+	myRect=r;
+	this->lit=lit;
+	return true;
+}
+
+/*!\brief Cursor zeichnen
+ *
+ * \param draw Drawable, in das gezeichnet wird
+ * \param x X-Koordinate von \p draw im Client-Bereich des Eingabefelds
+ * \param y Y-Koordinate von \p draw im Client-Bereich des Eingabefelds
+ */
+void Caret::paint(Drawable& draw, int x, int y) const
+{
+	if (!lit) return;
+	draw.fillRect(myRect.left() - x, myRect.top() - y, myRect.left() + myRect.width() - x, myRect.top() + myRect.height() - y, myColor);
+}
+
+
+}	// EOF namespace ppltk
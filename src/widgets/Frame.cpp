@@ -107,10 +107,28 @@ void Frame::setBorderColorShadow(const Color& c)
 }
 
 void Frame::paint(Drawable& draw)
+{
+	// Ohne Rahmen ist cls genauso schnell wie das Kopieren aus dem Cache, transparente
+	// Frames zeichnen nur die Linien
+	if (myBorderStyle == NoBorder || isTransparent()) {
+		paintChrome(draw);
+		return;
+	}
+	bool created;
+	ChromeCache::Key key("Frame", draw.size(), myBorderStyle, myBackground, myBorderColorLight, myBorderColorShadow);
+	Drawable* chrome=GetWindowManager()->chromeCache().lookup(key, created);
+	if (!chrome) paintChrome(draw);
+	else {
+		if (created) paintChrome(*chrome);
+		draw.blt(*chrome);
+	}
+}
+
+void Frame::paintChrome(Drawable& draw)
 {
 	Color bg;
-	int w=width() - 1;
-	int h=height() - 1;
+	int w=draw.width() - 1;
+	int h=draw.height() - 1;
 	bool myTransparent=isTransparent();
 	switch (myBorderStyle) {
 		case NoBorder:
@@ -150,6 +168,12 @@ String Frame::widgetType() const
 	return "Frame";
 }
 
+bool Frame::isOpaque() const
+{
+	// paint füllt den kompletten Hintergrund, sofern das Widget nicht transparent ist
+	return !isTransparent();
+}
+
 
 
 }	// EOF namespace ppltk
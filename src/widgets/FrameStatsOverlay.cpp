@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+
+#include "ppltk.h"
+#include <vector>
+#include <algorithm>
+
+
+namespace ppltk {
+
+using namespace ppl7;
+using namespace ppl7::grafix;
+
+/*!\class FrameStatsOverlay
+ * \brief Einblendung der Frame-Statistik
+ *
+ * \desc
+ * Zeigt die Werte von Window::drawStatistics des Fensters an, in dem das Overlay
+ * liegt, und aktualisiert sie zweimal pro Sekunde. Das Neuzeichnen des Overlays
+ * selbst zählt nicht mit. Solange das Overlay existiert, ist die
+ * Zeitmessung pro Widget-Typ eingeschaltet. Mit setHighlightRepaints werden zusätzlich
+ * alle neu gezeichneten Widgets mit dem Rahmen von Widget::setDebugPaint markiert.
+ */
+
+FrameStatsOverlay::FrameStatsOverlay(int x, int y, int width, int height)
+{
+	create(x, y, width, height);
+	setTopmost(true);
+	setExcludedFromFrameStats(true);
+	const WidgetStyle& style=GetWidgetStyle();
+	myFont=style.labelFont;
+	myFont.setColor(Color(255, 255, 255, 255));
+	myFont.setOrientation(Font::TOP);
+	WindowManager* wm=GetWindowManager();
+	enabledStats=!wm->isFrameStatsEnabled();
+	if (enabledStats) wm->setFrameStatsEnabled(true);
+	timer_id=wm->startTimer(this, 500);
+}
+
+FrameStatsOverlay::~FrameStatsOverlay()
+{
+	WindowManager* wm=GetWindowManager();
+	wm->removeTimer(timer_id);
+	if (enabledStats) wm->setFrameStatsEnabled(false);
+	Widget::setHighlightRepaints(false);
+}
+
+void FrameStatsOverlay::setHighlightRepaints(bool enable)
+{
+	Widget::setHighlightRepaints(enable);
+}
+
+String FrameStatsOverlay::widgetType() const
+{
+	return "FrameStatsOverlay";
+}
+
+void FrameStatsOverlay::timerEvent(Event* event)
+{
+	// Kopie, damit das Zeichnen des Overlays nicht die angezeigten Werte verändert
+	Window* window=dynamic_cast<Window*>(getTopmostParent());
+	if (window) stats=window->drawStatistics();
+	else stats=GetWindowManager()->frameStats();
+	needsRedraw();
+}
+
+static bool comparePaintTime(const std::pair<String, FrameStats::PaintTime>& a, const std::pair<String, FrameStats::PaintTime>& b)
+{
+	return a.second.time > b.second.time;
+}
+
+void FrameStatsOverlay::paint(Drawable& draw)
+{
+	draw.cls(Color(0, 0, 0, 255));
+	int lh=myFont.measure("Xg").height + 2;
+	int x=6, y=4;
+	draw.print(myFont, x, y, ToString("painted: %zu, skipped: %zu", stats.widgetsPainted, stats.widgetsSkipped));
+	y+=lh;
+	draw.print(myFont, x, y, ToString("uploaded: %zu KB", stats.bytesUploaded / 1024));
+	y+=lh;
+	draw.print(myFont, x, y, ToString("events: %zu, layouts: %zu", stats.eventsDispatched, stats.layoutRecalculations));
+	y+=lh;
+	draw.print(myFont, x, y, ToString("events: %0.2f ms, draw: %0.2f ms", stats.eventTime, stats.drawTime));
+	y+=lh + 4;
+
+	std::vector<std::pair<String, FrameStats::PaintTime> > types(stats.paintTime.begin(), stats.paintTime.end());
+	std::sort(types.begin(), types.end(), comparePaintTime);
+	for (size_t i=0;i < types.size() && y + lh < draw.height();i++) {
+		draw.print(myFont, x, y, ToString("%s: %zu x, %0.3f ms", (const char*)types[i].first, types[i].second.count, types[i].second.time));
+		y+=lh;
+	}
+}
+
+
+}	// EOF namespace ppltk
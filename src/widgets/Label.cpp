@@ -167,8 +167,9 @@ void Label::paint(Drawable& draw)
 	}
 	myFont.setColor(myColor);
 	myFont.setOrientation(Font::TOP);
-	Size s=myFont.measure(myText);
-	d.print(myFont, x, (d.height() - s.height) >> 1, myText);
+	TextRunCache& cache=GetWindowManager()->textRunCache();
+	Size s=cache.measure(myFont, myText);
+	cache.print(d, myFont, x, (d.height() - s.height) >> 1, myText);
 }
 
 
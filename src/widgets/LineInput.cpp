@@ -33,6 +33,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "ppltk.h"
 
 
@@ -61,6 +62,8 @@ LineInput::LineInput()
 	overwrite=false;
 	timerId=0;
 	drag_started=false;
+	caret.setColor(myColor);
+	rebuildPrefixWidths();
 }
 
 LineInput::LineInput(int x, int y, int width, int height, const String& text)
@@ -85,6 +88,8 @@ LineInput::LineInput(int x, int y, int width, int height, const String& text)
 	overwrite=false;
 	timerId=0;
 	drag_started=false;
+	caret.setColor(myColor);
+	rebuildPrefixWidths();
 }
 
 LineInput::~LineInput()
@@ -126,6 +131,7 @@ void LineInput::setText(const String& text)
 	if (new_text == myText) return;
 	if (validator != NULL && validator->validateText(new_text) == false) return;
 	myText=new_text;
+	rebuildPrefixWidths();
 	startpos=0;
 	if (cursorpos > myText.size()) cursorpos=myText.size();
 	calcCursorPosition();
@@ -143,6 +149,7 @@ const Color& LineInput::color() const
 void LineInput::setColor(const Color& c)
 {
 	myColor=c;
+	caret.setColor(c);
 	needsRedraw();
 }
 
@@ -164,7 +171,9 @@ const Font& LineInput::font() const
 void LineInput::setFont(const Font& font)
 {
 	myFont=font;
-	needsRedraw();
+	rebuildPrefixWidths();
+	calcCursorPosition();
+	calcSelectionPosition();
 	geometryChanged();
 }
 
@@ -196,21 +205,85 @@ String LineInput::widgetType() const
 
 
 void LineInput::paint(Drawable& draw)
+{
+	paint(draw, Rect(0, 0, draw.width(), draw.height()));
+}
+
+bool LineInput::canPaintPartially() const
+{
+	// Beim Wechsel der Hintergrundfarbe muss auch der Rahmen neu gezeichnet werden
+	Color bg=myBackgroundColor;
+	if (myText != validatedText && validator != NULL) bg=GetWidgetStyle().inputInvalidBackgroundColor;
+	return bg == Frame::backgroundColor();
+}
+
+void LineInput::paint(Drawable& draw, const Rect& clip)
 {
 	const WidgetStyle& style=GetWidgetStyle();
-	if (myText != validatedText && validator != NULL) Frame::setBackgroundColor(style.inputInvalidBackgroundColor);
-	else Frame::setBackgroundColor(myBackgroundColor);
-	Frame::paint(draw);
-	Drawable d=clientDrawable(draw);
-	if (selection.x1 != selection.x2) d.fillRect(selection.x1, 0, selection.x2, d.height(), style.inputSelectedBackgroundColor);
+	Color bg=myBackgroundColor;
+	if (myText != validatedText && validator != NULL) bg=style.inputInvalidBackgroundColor;
+	bool partial=(clip.width() < draw.width() || clip.height() < draw.height());
+	if (bg != Frame::backgroundColor()) {
+		// schaltet auf komplettes Neuzeichnen um
+		Frame::setBackgroundColor(bg);
+		partial=false;
+	}
+	Drawable client=clientDrawable(draw);
+	Drawable d;
+	int ox=0, oy=0;
+	if (partial) {
+		// Nur den Clip-Bereich innerhalb des Client-Bereichs neu zeichnen
+		Rect cr=clientRect();
+		ox=clip.left() - cr.left();
+		oy=clip.top() - cr.top();
+		int x2=ox + clip.width();
+		int y2=oy + clip.height();
+		if (ox < 0) ox=0;
+		if (oy < 0) oy=0;
+		if (x2 > client.width()) x2=client.width();
+		if (y2 > client.height()) y2=client.height();
+		if (x2 <= ox || y2 <= oy) return;
+		d.copy(client, Point(ox, oy), Size(x2 - ox, y2 - oy));
+		d.cls(bg);
+	} else {
+		Frame::paint(draw);
+		d=client;
+	}
+	if (selection.x1 != selection.x2) d.fillRect(selection.x1 - ox, -oy, selection.x2 - ox, client.height() - oy, style.inputSelectedBackgroundColor);
 	//printf ("Text: %s, width: %i, height: %i\n",(const char*)myText, d.width(), d.height());
 	int x=0;
+	if (startpos < prefixWidth.size()) x=-prefixWidth[startpos];
 	myFont.setColor(myColor);
 	myFont.setOrientation(Font::TOP);
-	Size s=myFont.measure(myText);
-	d.print(myFont, x, (d.height() - s.height) >> 1, myText);
+	int text_height=GlyphMetrics::get(myFont).height();
+	if (prefixWidth.size() != myText.size() + 1) rebuildPrefixWidths();
+	// Nur die Zeichen ausgeben, die in den neu gezeichneten Bereich fallen. Je ein
+	// Zeichen mehr an den Rändern deckt Überhänge kursiver Glyphen ab.
+	size_t first=std::upper_bound(prefixWidth.begin(), prefixWidth.end(), ox - x) - prefixWidth.begin();
+	size_t last=std::lower_bound(prefixWidth.begin(), prefixWidth.end(), ox + d.width() - x) - prefixWidth.begin();
+	first=first > 1 ? first - 2 : 0;
+	if (last < myText.size()) last++;
+	if (last > myText.size()) last=myText.size();
+	if (first < last) {
+		d.print(myFont, x + prefixWidth[first] - ox, ((client.height() - text_height) >> 1) - oy,
+			myText.mid(first, last - first));
+	}
 	//d.invert(Rect(cursorx,0,cursorx+cursorwidth,d.height()),myColor,backgroundColor());
-	if (blinker) d.fillRect(cursorx, 0, cursorx + cursorwidth, d.height(), myColor);
+	caret.paint(d, ox, oy);
+}
+
+/*!\brief Cursor an Position und Blinkzustand anpassen
+ *
+ * \desc
+ * Markiert nur den Bereich des Cursors als neu zu zeichnen. Siehe Caret.
+ */
+void LineInput::updateCaret()
+{
+	Size client=clientSize();
+	Rect damage;
+	if (!caret.update(cursorx, 0, cursorwidth, client.height, blinker && cursorx + cursorwidth <= client.width, damage)) return;
+	Rect cr=clientRect();
+	needsRedraw(Rect(cr.left() + damage.left(), cr.top() + damage.top(), damage.width(), damage.height()));
 }
 
 void LineInput::mouseDownEvent(MouseEvent* event)
@@ -230,6 +303,7 @@ void LineInput::mouseDownEvent(MouseEvent* event)
 		WideString new_text=myText.left(cursorpos) + clipboard + myText.mid(cursorpos);
 		if (validator == NULL || validator->validateText(new_text) == true) {
 			myText=new_text;
+			updatePrefixWidths(cursorpos, 0, clipboard.size());
 			validateAndSendEvent(new_text);
 			cursorpos+=clipboard.size();
 		}
@@ -274,7 +348,7 @@ void LineInput::gotFocusEvent(FocusEvent* event)
 	//printf("LineInput::gotFocusEvent\n");
 	blinker=true;
 	if (!timerId) timerId=GetWindowManager()->startTimer(this, 500);
-	needsRedraw();
+	updateCaret();
 }
 
 void LineInput::lostFocusEvent(FocusEvent* event)
@@ -287,7 +361,7 @@ void LineInput::lostFocusEvent(FocusEvent* event)
 	blinker=false;
 	if (timerId) GetWindowManager()->removeTimer(timerId);
 	timerId=0;
-	needsRedraw();
+	updateCaret();
 }
 
 void LineInput::textInputEvent(TextInputEvent* event)
@@ -302,6 +376,7 @@ void LineInput::textInputEvent(TextInputEvent* event)
 	right=myText.mid(cursorpos);
 	left+=event->text + right;
 	myText=left;
+	updatePrefixWidths(cursorpos, 0, event->text.size());
 	cursorpos++;
 	calcCursorPosition();
 	selection.clear();
@@ -314,6 +389,7 @@ void LineInput::deleteSelection()
 	if (selection.exists()) {
 		WideString new_text=myText.left(selection.start) + myText.mid(selection.end);
 		myText=new_text;
+		updatePrefixWidths(selection.start, selection.end - selection.start, 0);
 		cursorpos=selection.start;
 		calcCursorPosition();
 		selection.clear();
@@ -344,6 +420,7 @@ void LineInput::keyDownEvent(KeyEvent* event)
 				} else {
 					WideString new_text=myText.left(cursorpos - 1) + myText.mid(cursorpos);
 					myText=new_text;
+					updatePrefixWidths(cursorpos - 1, 1, 0);
 					cursorpos--;
 				}
 				calcCursorPosition();
@@ -351,9 +428,10 @@ void LineInput::keyDownEvent(KeyEvent* event)
 			} else if (event->key == KeyEvent::KEY_DELETE) {
 				if (selection.exists()) {
 					deleteSelection();
-				} else {
+				} else if (cursorpos < myText.size()) {
 					WideString new_text=myText.left(cursorpos) + myText.mid(cursorpos + 1);
 					myText=new_text;
+					updatePrefixWidths(cursorpos, 1, 0);
 				}
 				calcCursorPosition();
 				validateAndSendEvent(myText);
@@ -378,6 +456,7 @@ void LineInput::keyDownEvent(KeyEvent* event)
 				if (validator == NULL || validator->validateText(new_text) == true) {
 					validateAndSendEvent(new_text);
 					myText=new_text;
+					updatePrefixWidths(cursorpos, 0, clipboard.size());
 					cursorpos+=clipboard.size();
 				}
 				calcCursorPosition();
@@ -429,7 +508,7 @@ void LineInput::keyUpEvent(KeyEvent* event)
 void LineInput::timerEvent(Event* event)
 {
 	blinker=!blinker;
-	needsRedraw();
+	updateCaret();
 	//if (GetWindowManager()->getKeyboardFocus()==this) GetWindowManager()->startTimer(this,500);
 	//else blinker=false;
 
@@ -464,44 +543,93 @@ void LineInput::mouseDblClickEvent(MouseEvent* event)
 }
 
 
+/*!\brief Breiten aller Textanfänge neu berechnen
+ *
+ * \desc
+ * prefixWidth[i] enthält die X-Position vor dem Zeichen \p i, das letzte Element
+ * die Breite des gesamten Textes. Cursor, Selektion, Scrollposition und Mausklicks
+ * werden daraus ohne erneutes Messen bestimmt.
+ */
+void LineInput::rebuildPrefixWidths()
+{
+	GlyphMetrics::get(myFont).prefixWidths(myText, prefixWidth);
+}
+
+/*!\brief Breiten nach einer Textänderung anpassen
+ *
+ * \desc
+ * Muss aufgerufen werden, nachdem in myText an Position \p pos \p removed Zeichen
+ * entfernt und \p inserted Zeichen eingefügt wurden. Neu gemessen werden nur die
+ * eingefügten Zeichen und das Kerning an den Rändern, alle folgenden Einträge werden
+ * um die Differenz verschoben.
+ */
+void LineInput::updatePrefixWidths(size_t pos, size_t removed, size_t inserted)
+{
+	size_t size=myText.size();
+	if (pos > size || prefixWidth.size() + inserted != size + 1 + removed) {
+		rebuildPrefixWidths();
+		return;
+	}
+	GlyphMetrics& metrics=GlyphMetrics::get(myFont);
+	// Ab diesem Eintrag ändern sich die Positionen nur noch um einen festen Betrag
+	size_t fixed=pos + inserted + 1;
+	int old_fixed=0;
+	if (pos + removed + 1 < prefixWidth.size()) old_fixed=prefixWidth[pos + removed + 1];
+	if (removed > inserted) {
+		prefixWidth.erase(prefixWidth.begin() + pos + 1, prefixWidth.begin() + pos + 1 + (removed - inserted));
+	} else if (inserted > removed) {
+		prefixWidth.insert(prefixWidth.begin() + pos + 1, inserted - removed, 0);
+	}
+	for (size_t k=pos + 1;k <= fixed && k <= size;k++) {
+		int x=prefixWidth[k - 1] + metrics.advance(myText[k - 1]);
+		if (k > 1) x+=metrics.kerning(myText[k - 2], myText[k - 1]);
+		prefixWidth[k]=x;
+	}
+	if (fixed < size) {
+		int delta=prefixWidth[fixed] - old_fixed;
+		if (delta != 0) {
+			for (size_t k=fixed + 1;k <= size;k++) prefixWidth[k]+=delta;
+		}
+	}
+}
+
 void LineInput::calcCursorPosition()
 {
-	WideString text=myText, left, right;
-	Size s1;
 	if ((ssize_t)cursorpos < 0) cursorpos=0;
-	if (cursorpos > text.size()) cursorpos=text.size();
-	if (cursorpos == 0) {
-		cursorx=0;
-		startpos=0;
-	} else {
-		left=text.left(cursorpos);
-		right=text.mid(cursorpos);
-		s1=myFont.measure(left);
-		cursorx=s1.width;
+	if (cursorpos > myText.size()) cursorpos=myText.size();
+	if (prefixWidth.size() != myText.size() + 1) rebuildPrefixWidths();
+	size_t old_startpos=startpos;
+	if (startpos > cursorpos) startpos=cursorpos;
+	// Text horizontal verschieben, damit der Cursor sichtbar bleibt
+	int visible=clientRect().width() - cursorwidth;
+	if (visible > 0 && prefixWidth[cursorpos] - prefixWidth[startpos] > visible) {
+		startpos=std::lower_bound(prefixWidth.begin(), prefixWidth.begin() + cursorpos,
+			prefixWidth[cursorpos] - visible) - prefixWidth.begin();
+	}
+	if (startpos > 0 && prefixWidth[myText.size()] - prefixWidth[startpos] < visible) {
+		// Am Textende keinen leeren Bereich stehen lassen
+		startpos=std::lower_bound(prefixWidth.begin(), prefixWidth.begin() + startpos,
+			prefixWidth[myText.size()] - visible) - prefixWidth.begin();
 	}
+	cursorx=prefixWidth[cursorpos] - prefixWidth[startpos];
+	if (startpos != old_startpos) calcSelectionPosition();
+	updateCaret();
 	needsRedraw();
 }
 
 int LineInput::calcPosition(int x)
 {
-	WideString text;
-	size_t c=0;
-	Size s1;
-	while (c < myText.size()) {
-		text=myText.left(c + 1);
-		s1=myFont.measure(text);
-		if (x < s1.width) break;
-		c++;
-	}
-
-	return c;
+	if (prefixWidth.size() != myText.size() + 1) rebuildPrefixWidths();
+	x+=prefixWidth[startpos];
+	// Erstes Zeichen, dessen rechter Rand hinter x liegt
+	return std::upper_bound(prefixWidth.begin() + 1, prefixWidth.end(), x) - (prefixWidth.begin() + 1);
 }
 
 int LineInput::getDrawStartPositionOfChar(size_t pos)
 {
-	WideString text=myText.left(pos);
-	Size s1=myFont.measure(text);
-	return s1.width;
+	if (prefixWidth.size() != myText.size() + 1) rebuildPrefixWidths();
+	if (pos > myText.size()) pos=myText.size();
+	return prefixWidth[pos] - prefixWidth[startpos];
 }
 
 void LineInput::calcSelectionPosition()
@@ -32,6 +32,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "ppltk.h"
 
 
@@ -45,6 +46,7 @@ TextEdit::TextEdit()
 	:Frame()
 {
 	validator=NULL;
+	textCopyValid=false;
 	const WidgetStyle& style=GetWidgetStyle();
 	setBorderStyle(Inset);
 	myColor=style.inputFontColor;
@@ -67,21 +69,23 @@ TextEdit::TextEdit()
 	cache_is_valid=false;
 	vertical_scrollbar=NULL;
 	first_cursor_up_down_x=-1;
+	caret.setColor(myColor);
 }
 
 TextEdit::TextEdit(int x, int y, int width, int height, const String& text)
 	:Frame(x, y, width, height)
 {
 	validator=NULL;
+	textCopyValid=false;
 	const WidgetStyle& style=GetWidgetStyle();
 	setBorderStyle(Inset);
 	myColor=style.inputFontColor;
 	myFont=style.inputFont;
 	setBackgroundColor(style.inputBackgroundColor);
 	setTransparent(false);
-	myText=text;
+	myText=WideString(text);
 	if (validator) {
-		if (validator->validateText(text) == true) validatedText=text;
+		if (validator->validateText(text) == true) validatedText=myText;
 	}
 	cursorpos=0;
 	cursorx=0;
@@ -98,6 +102,7 @@ TextEdit::TextEdit(int x, int y, int width, int height, const String& text)
 	cache_is_valid=false;
 	vertical_scrollbar=NULL;
 	first_cursor_up_down_x=-1;
+	caret.setColor(myColor);
 }
 
 String TextEdit::widgetType() const
@@ -150,44 +155,84 @@ void TextEdit::moveScrollbarToCursor()
 	int sline=vertical_scrollbar->position();
 	if (current_line < sline)  vertical_scrollbar->setPosition(current_line);
 	else if (current_line > sline + visible_lines) vertical_scrollbar->setPosition(current_line - visible_lines);
+	updateCaret();
 }
 
 void TextEdit::invalidateCache()
 {
 	cache_is_valid=false;
-	position_cache.clear();
+	paragraphs.clear();
 }
 
+/*!\brief Aktueller Text
+ *
+ * \desc
+ * Der Text wird intern in einem TextBuffer gehalten und erst beim ersten Aufruf nach
+ * einer Änderung zusammengesetzt. Die Referenz bleibt gültig, bis der Text geändert wird.
+ */
 const ppl7::WideString& TextEdit::text() const
 {
-	if (validator) return validatedText;
-	else return myText;
+	if (!textCopyValid) {
+		if (validator) textCopy=validatedText.toWideString();
+		else textCopy=myText.toWideString();
+		textCopyValid=true;
+	}
+	return textCopy;
 }
 
-void TextEdit::validateAndSendEvent(const WideString& text)
+/*!\brief Text prüfen und TextChanged-Event senden
+ *
+ * \desc
+ * textChangedEvent wird immer aufgerufen. Der Text wird aber nur dann als String
+ * zusammengesetzt, wenn ein InputValidator, ein EventHandler oder eine abgeleitete
+ * Klasse ihn brauchen kann.
+ */
+void TextEdit::validateAndSendEvent()
 {
+	textCopyValid=false;
 	if (validator) {
+		WideString text=myText.toWideString();
 		if (validator->validateText(text) == false) return;
+		textCopy=text;
+		textCopyValid=true;
 	}
-	validatedText=text;
+	validatedText=myText;
 	Event ev(Event::Type::TextChanged);
 	ev.setWidget(this);
-	textChangedEvent(&ev, validatedText);
+	// Ohne EventHandler und ohne abgeleitete Klasse, die textChangedEvent
+	// überschreiben könnte, wird der Text nicht gebraucht
+	if (!getEventHandler() && typeid(*this) == typeid(TextEdit)) textChangedEvent(&ev, String());
+	else textChangedEvent(&ev, text());
+}
+
+/*!\brief Text an der Cursorposition einfügen
+ *
+ * \desc
+ * Mit InputValidator wird vorher geprüft, ob der Text danach noch gültig wäre.
+ */
+void TextEdit::insertText(const WideString& text)
+{
+	if (validator != NULL && validator->validateText(myText.mid(0, cursorpos) + text + myText.mid(cursorpos)) == false) return;
+	myText.insert(cursorpos, text);
+	textChanged(cursorpos, 0, text.size());
+	validateAndSendEvent();
+	cursorpos+=text.size();
 }
 
 void TextEdit::setText(const String& text)
 {
 	WideString new_text=text;
-	if (new_text == myText) return;
+	if (myText.size() == new_text.size() && new_text == myText.toWideString()) return;
 	if (validator != NULL && validator->validateText(new_text) == false) return;
 	myText=new_text;
+	textCopyValid=false;
 	if (cursorpos > myText.size()) cursorpos=myText.size();
 	calcCursorPosition();
 	selection.clear();
 	needsRedraw();
 	invalidateCache();
 	geometryChanged();
-	validateAndSendEvent(myText);
+	validateAndSendEvent();
 }
 
 const ppl7::grafix::Color& TextEdit::color() const
@@ -198,6 +243,7 @@ const ppl7::grafix::Color& TextEdit::color() const
 void TextEdit::setColor(const Color& c)
 {
 	myColor=c;
+	caret.setColor(c);
 	needsRedraw();
 }
 
@@ -228,112 +274,329 @@ ppl7::grafix::Size TextEdit::minimumSizeHint() const
 }
 
 
-static ppl7::WideString GetWord(const ppl7::WideString& string, size_t& p)
+static ppl7::WideString GetWord(TextBuffer::const_iterator& it, const TextBuffer::const_iterator& end)
 {
 	ppl7::WideString word;
-	while (p < string.size()) {
-		wchar_t c=string[p];
+	while (it != end) {
+		wchar_t c=*it;
 		switch (c) {
 			case '\n':
 			case ' ':
 				if (word.size() > 0) return word;
 				word.append(c);
-				p++;
+				++it;
 				return word;
 			case '-':
 				word.append(c);
-				p++;
+				++it;
 				return word;
 			default:
 				word.append(c);
-				p++;
+				++it;
 		}
 	}
 	return word;
 }
 
-void TextEdit::addToCache(const ppl7::WideString& word, int x, int y, int line)
+void TextEdit::addToCache(GlyphLayout& glyphs, const ppl7::WideString& word, int x, int line)
 {
+	GlyphMetrics& metrics=GlyphMetrics::get(myFont);
 	size_t p=0;
-	ppl7::WideString letter;
-	CacheItem item;
 	while (p < word.size()) {
-		letter.set(word[p]);
-		item.letter=word[p];
-		item.size=myFont.measure(letter);
-		item.line=line;
-		item.p.x=x;
-		item.p.y=y;
-		position_cache.insert(std::pair<size_t, TextEdit::CacheItem>(position_cache.size(), item));
-		x+=item.size.width;
+		int width=metrics.advance(word[p]);
+		if (p + 1 < word.size()) width+=metrics.kerning(word[p], word[p + 1]);
+		glyphs.append(x, width, line);
+		x+=width;
 		p++;
 	}
 }
 
-void TextEdit::rebuildCache(int width)
+/*!\brief Absätze umbrechen
+ *
+ * \desc
+ * Bricht den Text von \p start bis ausschließlich \p end in Zeilen der Breite
+ * cache_line_width um und hängt für jeden Absatz einen Eintrag an \p result an.
+ * Ein Absatz endet hinter einem Zeilenumbruch, \p start und \p end müssen daher auf
+ * Absatzgrenzen liegen. Endet der Text mit einem Zeilenumbruch, folgt noch ein leerer
+ * Absatz für die Zeile, in der der Cursor dann steht.
+ *
+ * \param start Position des ersten Zeichens
+ * \param end Position hinter dem letzten Zeichen
+ * \param first_line Zeilennummer des ersten Absatzes
+ * \param result Liste, an die die Absätze angehängt werden
+ */
+void TextEdit::layoutParagraphs(size_t start, size_t end, int first_line, std::vector<Paragraph>& result)
 {
-	position_cache.clear();
-	int line=0;
-	int x=0;
-	int y=0;
-	ppl7::grafix::Size s=myFont.measure(L" ");
-	line_height=s.height;
-	//ppl7::PrintDebug("TextEdit::rebuildCache\n");
-	size_t p=0;
-	while (p < myText.size()) {
-		ppl7::WideString word=GetWord(myText, p);
-		if (word.size()) {
+	GlyphMetrics& metrics=GlyphMetrics::get(myFont);
+	TextBuffer::const_iterator it=myText.at(start);
+	TextBuffer::const_iterator stop=myText.at(end);
+	int line=first_line;
+	while (it != stop) {
+		result.push_back(Paragraph());
+		Paragraph& para=result.back();
+		para.start=it.position();
+		para.first_line=line;
+		int row=0;
+		int x=0;
+		wchar_t last_char=0;
+		while (it != stop) {
+			ppl7::WideString word=GetWord(it, stop);
+			if (!word.size()) break;
+			// Kerning zum vorherigen Wort der Zeile, damit die Zeile genauso breit ist,
+			// wie sie von paintText am Stück gedruckt wird
+			int kerning=0;
+			GlyphLayout& g=para.glyphs;
+			if (g.size() > 0 && g.line.back() == row) kerning=metrics.kerning(last_char, word[0]);
+			last_char=word[word.size() - 1];
 			if (word[0] == '\n') {
-				addToCache(word, x, y, line);
-				x=0;
-				y+=line_height;
-				line++;
+				addToCache(g, word, x, row);
+				break;
 			} else if (word[0] == ' ') {
-				s=myFont.measure(word);
-				addToCache(word, x, y, line);
-				x+=s.width;
+				if (kerning) {
+					g.width.back()+=kerning;
+					x+=kerning;
+				}
+				addToCache(g, word, x, row);
+				x+=metrics.width(word);
 			} else {
-				s=myFont.measure(word);
-				if (x + s.width >= width) {
+				int word_width=metrics.width(word);
+				if (x + kerning + word_width >= cache_line_width) {
 					x=0;
-					y+=line_height;
-					line++;
+					row++;
+				} else if (kerning) {
+					g.width.back()+=kerning;
+					x+=kerning;
 				}
-				addToCache(word, x, y, line);
-				x+=s.width;
+				addToCache(g, word, x, row);
+				x+=word_width;
 			}
 		}
+		para.lines=row + 1;
+		para.rows.resize(para.lines);
+		size_t o=0;
+		for (int i=0;i < para.lines;i++) {
+			while (o < para.glyphs.size() && para.glyphs.line[o] < i) o++;
+			para.rows[i]=o;
+		}
+		line+=para.lines;
+	}
+	if (end == myText.size() && (end == start || myText[end - 1] == '\n')) {
+		result.push_back(Paragraph());
+		Paragraph& para=result.back();
+		para.start=end;
+		para.first_line=line;
+		para.lines=1;
+		para.rows.push_back(0);
 	}
+}
+
+void TextEdit::rebuildCache(int width)
+{
+	paragraphs.clear();
+	line_height=GlyphMetrics::get(myFont).height();
 	cache_line_width=width;
-	total_lines=line;
+	//ppl7::PrintDebug("TextEdit::rebuildCache\n");
+	layoutParagraphs(0, myText.size(), 0, paragraphs);
+	total_lines=paragraphs.back().first_line + paragraphs.back().lines - 1;
 	cache_is_valid=true;
 	calcCursorPosition();
 }
 
+/*!\brief Umbruch nach einer Textänderung anpassen
+ *
+ * \desc
+ * Muss aufgerufen werden, nachdem in myText an Position \p pos \p removed Zeichen
+ * entfernt und \p inserted Zeichen eingefügt wurden. Neu umgebrochen werden nur die
+ * Absätze, die von der Änderung betroffen sind. Bei allen folgenden Absätzen werden
+ * lediglich Startposition und erste Zeile verschoben. Der Umbruch kostet daher die
+ * Länge der betroffenen Absätze, das Verschieben bleibt aber linear in der Anzahl
+ * der Absätze dahinter.
+ */
+void TextEdit::textChanged(size_t pos, size_t removed, size_t inserted)
+{
+	if (!validator) textCopyValid=false;
+	if (!cache_is_valid) return;
+	size_t old_size=myText.size() + removed - inserted;
+	if (paragraphs.empty() || glyphCount() != old_size || pos + removed > old_size) {
+		invalidateCache();
+		return;
+	}
+	size_t first=findParagraph(pos);
+	size_t last=findParagraph(pos + removed);
+	size_t old_end=old_size;
+	if (last + 1 < paragraphs.size()) old_end=paragraphs[last + 1].start;
+	int first_line=paragraphs[first].first_line;
+	int old_lines=paragraphs[last].first_line + paragraphs[last].lines - first_line;
+
+	std::vector<Paragraph> layout;
+	layoutParagraphs(paragraphs[first].start, old_end + inserted - removed, first_line, layout);
+	if (layout.empty()) {
+		invalidateCache();
+		return;
+	}
+	int new_lines=layout.back().first_line + layout.back().lines - first_line;
+	int delta_lines=new_lines - old_lines;
+
+	if (layout.size() == last - first + 1) {
+		// Anzahl der Absätze unverändert, die übrigen Einträge müssen nicht wandern
+		for (size_t k=0;k < layout.size();k++) std::swap(paragraphs[first + k], layout[k]);
+	} else {
+		paragraphs.erase(paragraphs.begin() + first, paragraphs.begin() + last + 1);
+		paragraphs.insert(paragraphs.begin() + first, layout.begin(), layout.end());
+	}
+	for (size_t k=first + layout.size();k < paragraphs.size();k++) {
+		paragraphs[k].start=paragraphs[k].start + inserted - removed;
+		paragraphs[k].first_line+=delta_lines;
+	}
+	total_lines+=delta_lines;
+}
+
+/*!\brief Absatz einer Textposition
+ *
+ * \return Index des letzten Absatzes, der an oder vor \p pos beginnt
+ */
+size_t TextEdit::findParagraph(size_t pos) const
+{
+	size_t low=0, high=paragraphs.size();
+	while (high - low > 1) {
+		size_t mid=(low + high) / 2;
+		if (paragraphs[mid].start <= pos) low=mid;
+		else high=mid;
+	}
+	return low;
+}
+
+/*!\brief Absatz einer Zeile
+ *
+ * \return Index des letzten Absatzes, der in oder vor der Zeile \p line beginnt
+ */
+size_t TextEdit::findParagraphOfLine(int line) const
+{
+	size_t low=0, high=paragraphs.size();
+	while (high - low > 1) {
+		size_t mid=(low + high) / 2;
+		if (paragraphs[mid].first_line <= line) low=mid;
+		else high=mid;
+	}
+	return low;
+}
+
+/*!\brief Position des ersten Zeichens einer Zeile
+ *
+ * \desc
+ * Zusammen mit Paragraph::rows bildet die Liste der Absätze einen Zeilenindex. Die
+ * Y-Position einer Zeile ist immer line * line_height.
+ *
+ * \return Position des ersten Zeichens der Zeile \p line. Liegt die Zeile hinter
+ * dem Text, wird die Anzahl Zeichen zurückgegeben.
+ */
+size_t TextEdit::positionOfLine(int line) const
+{
+	if (paragraphs.empty() || line <= 0) return 0;
+	const Paragraph& para=paragraphs[findParagraphOfLine(line)];
+	int row=line - para.first_line;
+	if (row >= para.lines) return glyphCount();
+	return para.start + para.rows[row];
+}
+
+/*!\brief Zeilen, die den Bereich \p area schneiden
+ *
+ * \param area Zu zeichnender Bereich in Client-Koordinaten
+ * \param first Erhält die erste sichtbare Zeile
+ * \param last Erhält die Zeile hinter der letzten sichtbaren Zeile
+ */
+void TextEdit::visibleLines(const Rect& area, int& first, int& last) const
+{
+	int start_line=0;
+	if (vertical_scrollbar) start_line=vertical_scrollbar->position();
+	first=start_line;
+	last=start_line + visible_lines + 1;
+	if (line_height <= 0) return;
+	int top=start_line + area.top() / line_height;
+	int bottom=start_line + (area.top() + area.height() - 1) / line_height + 1;
+	if (top > first) first=top;
+	if (bottom < last) last=bottom;
+}
 
-void TextEdit::paintSelection(Drawable& draw)
+size_t TextEdit::glyphCount() const
 {
-	int start_y=0;
-	if (vertical_scrollbar) start_y=vertical_scrollbar->position() * line_height;
-	//int end_line=start_line + visible_lines + 1;
+	if (paragraphs.empty()) return 0;
+	return paragraphs.back().start + paragraphs.back().glyphs.size();
+}
 
 
+void TextEdit::paintSelection(Drawable& draw, const Rect& area)
+{
+	int start_y=area.top();
+	if (vertical_scrollbar) start_y+=vertical_scrollbar->position() * line_height;
+	int start_x=area.left();
+
+	if (paragraphs.empty()) return;
+	size_t count=glyphCount();
+	size_t sel_start=selection.start;
+	size_t sel_end=selection.end + 1;
+	if (sel_end > count) sel_end=count;
+	int first_line, last_line;
+	visibleLines(area, first_line, last_line);
 	const WidgetStyle& style=GetWidgetStyle();
-	for (int i=selection.start;i <= selection.end;i++) {
-		std::map<size_t, CacheItem>::const_iterator it=position_cache.find(i);
-		if (it != position_cache.end()) {
-			draw.fillRect(it->second.p.x, it->second.p.y - start_y, it->second.p.x + it->second.size.width, it->second.p.y - start_y + it->second.size.height,
-				style.inputSelectedBackgroundColor);
-		}
+	// Pro sichtbarer Zeile ein Rechteck vom ersten bis zum letzten selektierten Zeichen
+	size_t line_start=positionOfLine(first_line);
+	for (int line=first_line;line < last_line && line_start < sel_end;line++) {
+		size_t line_end=positionOfLine(line + 1);
+		size_t a=line_start > sel_start ? line_start : sel_start;
+		size_t b=line_end < sel_end ? line_end : sel_end;
+		line_start=line_end;
+		if (a >= b) continue;
+		const Paragraph& first=paragraphs[findParagraph(a)];
+		const Paragraph& last=paragraphs[findParagraph(b - 1)];
+		int x1=first.glyphs.x[a - first.start];
+		int x2=last.glyphs.x[b - 1 - last.start] + last.glyphs.width[b - 1 - last.start];
+		int y=line * line_height - start_y;
+		draw.fillRect(x1 - start_x, y, x2 - start_x, y + line_height,
+			style.inputSelectedBackgroundColor);
 	}
 
 }
 
 void TextEdit::paint(Drawable& draw)
+{
+	paint(draw, Rect(0, 0, draw.width(), draw.height()));
+}
+
+bool TextEdit::canPaintPartially() const
+{
+	// Muss der Text neu umgebrochen werden, wird alles neu gezeichnet
+	int w=clientSize().width;
+	if (vertical_scrollbar) w-=vertical_scrollbar->width();
+	return (cache_is_valid && w == cache_line_width && line_height > 0);
+}
+
+void TextEdit::paint(Drawable& draw, const Rect& clip)
 {
 	const WidgetStyle& style=GetWidgetStyle();
+	bool partial=(clip.width() < draw.width() || clip.height() < draw.height());
+	if (partial) {
+		// Nur den Clip-Bereich innerhalb des Client-Bereichs neu zeichnen
+		Drawable client=clientDrawable(draw);
+		Rect cr=clientRect();
+		int x1=clip.left() - cr.left();
+		int y1=clip.top() - cr.top();
+		int x2=x1 + clip.width();
+		int y2=y1 + clip.height();
+		if (x1 < 0) x1=0;
+		if (y1 < 0) y1=0;
+		if (x2 > client.width()) x2=client.width();
+		if (y2 > client.height()) y2=client.height();
+		if (x2 <= x1 || y2 <= y1) return;
+		Drawable d;
+		d.copy(client, Point(x1, y1), Size(x2 - x1, y2 - y1));
+		if (validator != NULL && myText != validatedText) d.cls(style.inputInvalidBackgroundColor);
+		else d.cls(backgroundColor());
+		paintText(d, Rect(x1, y1, x2 - x1, y2 - y1));
+		return;
+	}
 	ppl7::grafix::Color saveBackgroundColor=backgroundColor();
-	if (myText != validatedText && validator != NULL) Frame::setBackgroundColor(style.inputInvalidBackgroundColor);
+	if (validator != NULL && myText != validatedText) Frame::setBackgroundColor(style.inputInvalidBackgroundColor);
 	Frame::paint(draw);
 	Frame::setBackgroundColor(saveBackgroundColor);
 
@@ -357,24 +620,79 @@ void TextEdit::paint(Drawable& draw)
 		updateScrollbar();
 
 	} else enableScrollbar(false);
+	paintText(d, Rect(0, 0, d.width(), d.height()));
+}
 
-	if (selection.exists()) paintSelection(d);
+/*!\brief Text, Selektion und Cursor zeichnen
+ *
+ * \param d Drawable, das den Bereich \p area des Client-Bereichs abbildet
+ * \param area Zu zeichnender Bereich in Client-Koordinaten
+ */
+void TextEdit::paintText(Drawable& d, const Rect& area)
+{
+	if (selection.exists()) paintSelection(d, area);
 	myFont.setColor(myColor);
 	myFont.setOrientation(Font::TOP);
-	WideString letter;
-	std::map<size_t, CacheItem>::const_iterator it;
 	int start_line=0;
 	if (vertical_scrollbar) start_line=vertical_scrollbar->position();
-	int end_line=start_line + visible_lines + 1;
-	int start_y=start_line * line_height;
-	for (it=position_cache.begin();it != position_cache.end();++it) {
-		if (it->second.letter != '\n' && it->second.line >= start_line && it->second.line < end_line) {
-			letter.set(it->second.letter);
-			d.print(myFont, it->second.p.x, it->second.p.y - start_y, letter);
+	int start_y=start_line * line_height + area.top();
+	int start_x=area.left();
+	int first_line, last_line;
+	visibleLines(area, first_line, last_line);
+	// Über den Zeilenindex nur die Zeichen der sichtbaren Zeilen besuchen und
+	// aufeinanderfolgende Zeichen einer Zeile mit einem Aufruf drucken
+	size_t pos=positionOfLine(first_line);
+	size_t end=positionOfLine(last_line);
+	if (end > glyphCount()) end=glyphCount();
+	if (end > myText.size()) end=myText.size();
+	if (pos < end) {
+		WideString run;
+		int run_x=0, run_y=0, run_end=0;
+		size_t k=findParagraph(pos);
+		TextBuffer::const_iterator text=myText.at(pos);
+		for (;pos < end;pos++, ++text) {
+			while (k + 1 < paragraphs.size() && paragraphs[k + 1].start <= pos) k++;
+			const Paragraph& para=paragraphs[k];
+			const GlyphLayout& g=para.glyphs;
+			size_t o=pos - para.start;
+			wchar_t c=*text;
+			int y=(para.first_line + g.line[o]) * line_height - start_y;
+			if (run.notEmpty() && (c == '\n' || y != run_y || g.x[o] != run_end)) {
+				d.print(myFont, run_x - start_x, run_y, run);
+				run.clear();
+			}
+			if (c == '\n') continue;
+			if (run.isEmpty()) {
+				run_x=g.x[o];
+				run_y=y;
+			}
+			run.append(c);
+			run_end=g.x[o] + g.width[o];
 		}
+		if (run.notEmpty()) d.print(myFont, run_x - start_x, run_y, run);
 	}
 	//if (vertical_scrollbar) ppl7::PrintDebug("line: %d, scrollbar-pos: %d\n", current_line, vertical_scrollbar->position());
-	if (blinker) d.fillRect(cursorx, cursory - start_line * line_height, cursorx + cursorwidth, cursory + line_height - start_line * line_height, myColor);
+	caret.paint(d, area.left(), area.top());
+}
+
+/*!\brief Cursor an Position und Blinkzustand anpassen
+ *
+ * \desc
+ * Markiert nur den Bereich des Cursors als neu zu zeichnen. Siehe Caret. Liegt er
+ * außerhalb des sichtbaren Textbereichs, wird er ausgeschaltet.
+ */
+void TextEdit::updateCaret()
+{
+	int y=cursory;
+	if (vertical_scrollbar) y-=vertical_scrollbar->position() * line_height;
+	Size client=clientSize();
+	if (vertical_scrollbar) client.width-=vertical_scrollbar->width();
+	int height=line_height > 0 ? line_height : 1;
+	bool lit=(blinker && y >= 0 && y + height <= client.height && cursorx + cursorwidth <= client.width);
+	Rect damage;
+	if (!caret.update(cursorx, y, cursorwidth, height, lit, damage)) return;
+	Rect cr=clientRect();
+	needsRedraw(Rect(cr.left() + damage.left(), cr.top() + damage.top(), damage.width(), damage.height()));
 }
 
 void TextEdit::mouseDownEvent(MouseEvent* event)
@@ -396,13 +714,7 @@ void TextEdit::mouseDownEvent(MouseEvent* event)
 		ppltk::GetWindowManager()->grabMouse(this);
 	} else if (event->buttonMask & ppltk::MouseEvent::MouseButton::Middle) {
 		WideString clipboard=String(GetWindowManager()->getClipboardText());
-		WideString new_text=myText.left(cursorpos) + clipboard + myText.mid(cursorpos);
-		if (validator == NULL || validator->validateText(new_text) == true) {
-			myText=new_text;
-			validateAndSendEvent(new_text);
-			cursorpos+=clipboard.size();
-		}
-		invalidateCache();
+		insertText(clipboard);
 
 	}
 	calcCursorPosition();
@@ -457,7 +769,7 @@ void TextEdit::gotFocusEvent(FocusEvent* event)
 	//ppl7::PrintDebug("TextEdit::gotFocusEvent\n");
 	blinker=true;
 	if (!timerId) timerId=GetWindowManager()->startTimer(this, 500);
-	needsRedraw();
+	updateCaret();
 }
 
 void TextEdit::lostFocusEvent(FocusEvent* event)
@@ -470,7 +782,7 @@ void TextEdit::lostFocusEvent(FocusEvent* event)
 	blinker=false;
 	if (timerId) GetWindowManager()->removeTimer(timerId);
 	timerId=0;
-	needsRedraw();
+	updateCaret();
 }
 
 void TextEdit::textInputEvent(TextInputEvent* event)
@@ -480,17 +792,14 @@ void TextEdit::textInputEvent(TextInputEvent* event)
 		if (validator->validateInput(event->text) == false) return;
 	}
 
-	WideString left, right;
 	deleteSelection();
-	left=myText.left(cursorpos);
-	right=myText.mid(cursorpos);
-	myText=left + event->text + right;
-	invalidateCache();
+	myText.insert(cursorpos, event->text);
+	textChanged(cursorpos, 0, event->text.size());
 	cursorpos++;
 	calcCursorPosition();
 	moveScrollbarToCursor();
 	selection.clear();
-	validateAndSendEvent(myText);
+	validateAndSendEvent();
 	/*
 	if (validator) {
 		if (validator->validateText(myText) == false) return;
@@ -502,8 +811,9 @@ void TextEdit::deleteSelection()
 {
 	//ppl7::PrintDebug("TextEdit::deleteSelection(): %d\n", selection.exists());
 	if (selection.exists()) {
-		WideString new_text=myText.left(selection.start) + myText.mid(selection.end + 1);
-		myText=new_text;
+		size_t old_size=myText.size();
+		myText.erase(selection.start, selection.end - selection.start + 1);
+		textChanged(selection.start, old_size - myText.size(), 0);
 		cursorpos=selection.start;
 		calcCursorPosition();
 		moveScrollbarToCursor();
@@ -573,24 +883,22 @@ void TextEdit::keyDownEvent(KeyEvent* event)
 			if (selection.exists()) {
 				deleteSelection();
 			} else {
-				WideString new_text=myText.left(cursorpos - 1) + myText.mid(cursorpos);
-				myText=new_text;
+				myText.erase(cursorpos - 1, 1);
+				textChanged(cursorpos - 1, 1, 0);
 				cursorpos--;
 			}
 			calcCursorPosition();
-			invalidateCache();
-			validateAndSendEvent(myText);
+			validateAndSendEvent();
 			blinker=true;
 		} else if (event->key == KeyEvent::KEY_DELETE) {
 			if (selection.exists()) {
 				deleteSelection();
-			} else {
-				WideString new_text=myText.left(cursorpos) + myText.mid(cursorpos + 1);
-				myText=new_text;
+			} else if (cursorpos < myText.size()) {
+				myText.erase(cursorpos, 1);
+				textChanged(cursorpos, 1, 0);
 			}
 			calcCursorPosition();
-			invalidateCache();
-			validateAndSendEvent(myText);
+			validateAndSendEvent();
 			blinker=true;
 		}
 
@@ -607,13 +915,7 @@ void TextEdit::keyDownEvent(KeyEvent* event)
 			} else if (event->key == KeyEvent::KEY_v) {
 				deleteSelection();
 				WideString clipboard=String(GetWindowManager()->getClipboardText());
-				WideString new_text=myText.left(cursorpos) + clipboard + myText.mid(cursorpos);
-				if (validator == NULL || validator->validateText(new_text) == true) {
-					myText=new_text;
-					validateAndSendEvent(new_text);
-					cursorpos+=clipboard.size();
-				}
-				invalidateCache();
+				insertText(clipboard);
 				calcCursorPosition();
 			} else if (event->key == KeyEvent::KEY_a) {
 				//ppl7::PrintDebug("select all\n");
@@ -655,7 +957,7 @@ void TextEdit::timerEvent(Event* event)
 {
 	//ppl7::PrintDebug("TextEdit::timerEvent\n");
 	blinker=!blinker;
-	needsRedraw();
+	updateCaret();
 	//if (GetWindowManager()->getKeyboardFocus()==this) GetWindowManager()->startTimer(this,500);
 	//else blinker=false;
 
@@ -693,59 +995,85 @@ void TextEdit::mouseDblClickEvent(MouseEvent* event)
 
 void TextEdit::calcCursorPosition()
 {
-	WideString text=myText, left;
-	Size s1;
 	if ((int)cursorpos < 0) cursorpos=0;
-	if (cursorpos > text.size()) cursorpos=text.size();
+	if (cursorpos > myText.size()) cursorpos=myText.size();
 	cursorx=0;
 	cursory=0;
 	current_line=0;
-	if (cursorpos > 0 && cursorpos >= position_cache.size()) {
-		std::map<size_t, CacheItem>::const_iterator it=position_cache.find(cursorpos - 1);
-		if (it != position_cache.end()) {
-			cursorx=it->second.p.x + it->second.size.width;
-			cursory=it->second.p.y;
-			current_line=it->second.line;
-
+	size_t glyphs=glyphCount();
+	if (cursorpos > 0 && cursorpos >= glyphs) {
+		size_t i=cursorpos - 1;
+		if (i < glyphs) {
+			const Paragraph& para=paragraphs[findParagraph(i)];
+			size_t o=i - para.start;
+			cursorx=para.glyphs.x[o] + para.glyphs.width[o];
+			current_line=para.first_line + para.glyphs.line[o];
+			cursory=current_line * line_height;
 		}
 	} else if (cursorpos > 0) {
-		std::map<size_t, CacheItem>::const_iterator it=position_cache.find(cursorpos);
-		if (it != position_cache.end()) {
-			cursorx=it->second.p.x;
-			cursory=it->second.p.y;
-			current_line=it->second.line;
-		}
+		const Paragraph& para=paragraphs[findParagraph(cursorpos)];
+		size_t o=cursorpos - para.start;
+		cursorx=para.glyphs.x[o];
+		current_line=para.first_line + para.glyphs.line[o];
+		cursory=current_line * line_height;
 	}
+	updateCaret();
 	needsRedraw();
 }
 
 int TextEdit::calcPosition(const ppl7::grafix::Point& p)
 {
+	if (paragraphs.empty() || line_height <= 0) return 0;
 	int l=p.y / line_height;
-	std::map<size_t, CacheItem>::const_iterator it;
 	int r=0, mx_y=0;
+	int size=(int)glyphCount();
 	//ppl7::PrintDebug("x=%d\n", p.x);
-	for (it=position_cache.begin();it != position_cache.end();++it) {
-		mx_y=it->second.p.y;
-		if (it->second.line == l) {
-			r=it->first;
-			if (it->second.p.x <= p.x && (it->second.p.x + it->second.size.width) > p.x) return it->first;
-			if (r == ((int)position_cache.size() - 1)) return (int)position_cache.size();
+	if (size > 0) {
+		size_t k=findParagraph(size - 1);
+		mx_y=(paragraphs[k].first_line + paragraphs[k].glyphs.line[size - 1 - paragraphs[k].start]) * line_height;
+	}
+	if (l >= 0) {
+		const Paragraph& para=paragraphs[findParagraphOfLine(l)];
+		int row=l - para.first_line;
+		if (row < para.lines) {
+			const GlyphLayout& g=para.glyphs;
+			size_t first=para.rows[row];
+			size_t last=(row + 1 < para.lines) ? para.rows[row + 1] : g.size();
+			if (first < last) {
+				// Die Zeichen einer Zeile liegen lückenlos nebeneinander
+				size_t o=std::upper_bound(g.x.begin() + first, g.x.begin() + last, p.x) - g.x.begin();
+				if (o > first && g.x[o - 1] + g.width[o - 1] > p.x) return (int)(para.start + o - 1);
+				r=(int)(para.start + last - 1);
+				if (r == size - 1) return size;
+			}
 		}
 	}
-	if (p.y >= mx_y + line_height) r=position_cache.size() + 1;
+	if (p.y >= mx_y + line_height) r=size + 1;
 	return r;
 }
 
 ppl7::grafix::Point TextEdit::getDrawStartPositionOfChar(size_t pos)
 {
-	std::map<size_t, CacheItem>::const_iterator it=position_cache.find(pos);
-	if (it != position_cache.end()) {
-		return it->second.p;
+	if (pos < glyphCount()) {
+		const Paragraph& para=paragraphs[findParagraph(pos)];
+		size_t o=pos - para.start;
+		return ppl7::grafix::Point(para.glyphs.x[o], (para.first_line + para.glyphs.line[o]) * line_height);
 	}
 	return ppl7::grafix::Point(0, 0);
 }
 
+size_t TextEdit::GlyphLayout::size() const
+{
+	return x.size();
+}
+
+void TextEdit::GlyphLayout::append(int x, int width, int line)
+{
+	this->x.push_back(x);
+	this->width.push_back(width);
+	this->line.push_back(line);
+}
+
 TextEdit::Selection::Selection()
 {
 	start=-1;
@@ -813,6 +1141,7 @@ void TextEdit::valueChangedEvent(ppltk::Event* event, int value)
 {
 	if (vertical_scrollbar != NULL && event->widget() == vertical_scrollbar) {
 		//ppl7::PrintDebug("TextEdit::valueChangedEvent\n");
+		updateCaret();
 		needsRedraw();
 		return;
 	}
@@ -59,6 +59,12 @@ ppl7::String CheckBox::widgetType() const
 	return ppl7::String("CheckBox");
 }
 
+bool CheckBox::isOpaque() const
+{
+	// Der Bereich links vom Text wird nicht vom Hintergrund überdeckt
+	return false;
+}
+
 bool CheckBox::checked() const
 {
 	return ischecked;
@@ -42,6 +42,8 @@ ComboBox::ComboBox(int x, int y, int width, int height)
 	: ppltk::Widget()
 {
 	selection=NULL;
+	indexDirty=false;
+	updateDepth=0;
 	create(x, y, width, height);
 	ppltk::WindowManager* wm=ppltk::GetWindowManager();
 	myCurrentIndex=0;
@@ -60,18 +62,21 @@ ComboBox::~ComboBox()
 }
 
 
+void ComboBox::selectItem(size_t index)
+{
+	const ComboBoxItem& item=items[index];
+	myCurrentIndex=index;
+	myCurrentText=item.text;
+	myCurrentIdentifier=item.identifier;
+	needsRedraw();
+}
+
 void ComboBox::setCurrentText(const ppl7::String& text)
 {
 	if (text != myCurrentText) {
-		std::list<ComboBoxItem>::iterator it;
-		for (it=items.begin();it != items.end();++it) {
-			if ((*it).text == text) {
-				myCurrentIndex=(*it).index;
-				myCurrentText=(*it).text;
-				myCurrentIdentifier=(*it).identifier;
-				needsRedraw();
-			}
-		}
+		if (indexDirty) reindex();
+		Index::const_iterator it=textIndex.find(text);
+		if (it != textIndex.end()) selectItem(it->second);
 	}
 }
 
@@ -88,28 +93,14 @@ ppl7::String ComboBox::currentIdentifier() const
 void ComboBox::setCurrentIndex(size_t index)
 {
 	if (index >= items.size()) return;
-	std::list<ComboBoxItem>::iterator it;
-	for (it=items.begin();it != items.end();++it) {
-		if ((*it).index == index) {
-			myCurrentIndex=index;
-			myCurrentText=(*it).text;
-			myCurrentIdentifier=(*it).identifier;
-			needsRedraw();
-		}
-	}
+	selectItem(index);
 }
 
 void ComboBox::setCurrentIdentifier(const ppl7::String& identifier)
 {
-	std::list<ComboBoxItem>::iterator it;
-	for (it=items.begin();it != items.end();++it) {
-		if ((*it).identifier == identifier) {
-			myCurrentIndex=(*it).index;
-			myCurrentText=(*it).text;
-			myCurrentIdentifier=(*it).identifier;
-			needsRedraw();
-		}
-	}
+	if (indexDirty) reindex();
+	Index::const_iterator it=identifierIndex.find(identifier);
+	if (it != identifierIndex.end()) selectItem(it->second);
 }
 
 size_t ComboBox::currentIndex() const
@@ -117,6 +108,14 @@ size_t ComboBox::currentIndex() const
 	return myCurrentIndex;
 }
 
+/*!\brief Eintrag hinzufügen
+ *
+ * \desc
+ * Die Einträge liegen in einem Vektor, zusätzlich gibt es je einen Index über Text und
+ * Identifier. Hinzufügen und Auswählen kosten daher O(1), auch beim Laden sehr vieler
+ * Einträge. Bei mehrfach vorkommenden Texten oder Identifiern wählen setCurrentText
+ * und setCurrentIdentifier den zuletzt hinzugefügten Eintrag.
+ */
 void ComboBox::add(const ppl7::String& text, const ppl7::String& identifier)
 {
 	ComboBoxItem item;
@@ -124,10 +123,64 @@ void ComboBox::add(const ppl7::String& text, const ppl7::String& identifier)
 	item.identifier=identifier;
 	item.index=items.size();
 	items.push_back(item);
+	if (updateDepth > 0) {
+		indexDirty=true;
+		return;
+	}
+	if (!indexDirty) {
+		textIndex[text]=item.index;
+		identifierIndex[identifier]=item.index;
+	}
 	if (items.size() == 1) setCurrentIndex(0);
 	needsRedraw();
 }
 
+/*!\brief Mehrere Einträge am Stück hinzufügen
+ *
+ * \desc
+ * Bis zum passenden \ref endUpdate hängt \ref add die Einträge nur an. Die Indexe
+ * über Text und Identifier werden einmalig in \ref endUpdate aufgebaut, dort wird
+ * auch der erste Eintrag ausgewählt und neu gezeichnet. Aufrufe können verschachtelt
+ * werden.
+ */
+void ComboBox::beginUpdate()
+{
+	updateDepth++;
+}
+
+void ComboBox::endUpdate()
+{
+	if (updateDepth == 0) return;
+	updateDepth--;
+	if (updateDepth > 0) return;
+	if (indexDirty) reindex();
+	if (myCurrentText.isEmpty() && myCurrentIdentifier.isEmpty() && items.size() > 0) setCurrentIndex(0);
+	needsRedraw();
+}
+
+void ComboBox::addItems(const std::vector<ListWidget::ListWidgetItem>& items)
+{
+	beginUpdate();
+	this->items.reserve(this->items.size() + items.size());
+	for (auto it=items.begin();it != items.end();++it) {
+		add(it->text, it->identifier);
+	}
+	endUpdate();
+}
+
+void ComboBox::reindex()
+{
+	textIndex.clear();
+	identifierIndex.clear();
+	textIndex.reserve(items.size());
+	identifierIndex.reserve(items.size());
+	for (size_t i=0;i < items.size();i++) {
+		textIndex[items[i].text]=i;
+		identifierIndex[items[i].identifier]=i;
+	}
+	indexDirty=false;
+}
+
 void ComboBox::sortItems(SortOrder sort)
 {
 	ppl7::String current=currentIdentifier();
@@ -147,6 +200,7 @@ void ComboBox::sortItems(SortOrder sort)
 			items.push_back(it->second);
 		}
 	}
+	reindex();
 	setCurrentIdentifier(current);
 	needsRedraw();
 }
@@ -156,6 +210,9 @@ void ComboBox::clear()
 	myCurrentText.clear();
 	myCurrentIdentifier.clear();
 	items.clear();
+	textIndex.clear();
+	identifierIndex.clear();
+	indexDirty=false;
 	if (selection) delete selection;
 	selection=NULL;
 	ppltk::WindowManager* wm=ppltk::GetWindowManager();
@@ -221,10 +278,12 @@ void ComboBox::mouseDownEvent(ppltk::MouseEvent* event)
 			selection=new ListWidget(p.x, p.y + this->height(), this->width(), maxsize * 30);
 			selection->setTopmost(true);
 			selection->setEventHandler(this);
-			std::list<ComboBoxItem>::const_iterator it;
+			selection->beginUpdate();
+			std::vector<ComboBoxItem>::const_iterator it;
 			for (it=items.begin();it != items.end();++it) {
 				selection->add((*it).text, (*it).identifier);
 			}
+			selection->endUpdate();
 			selection->setCurrentIndex(myCurrentIndex);
 			window->addChild(selection);
 			dropdown_button->setIcon(wm->ButtonSymbols.getDrawable(3));
@@ -29,6 +29,7 @@
  *******************************************************************************/
 
 
+#include <algorithm>
 #include "ppltk.h"
 
 
@@ -38,20 +39,329 @@ using namespace ppl7;
 using namespace ppl7::grafix;
 
 
+ppl7::String ListModel::identifier(size_t) const
+{
+	return ppl7::String();
+}
+
+/*!\brief Zeile zu einem Text suchen
+ *
+ * \desc
+ * Die Standardimplementierung durchsucht alle Zeilen. Models mit vielen Einträgen
+ * sollten diese Funktion überschreiben, wenn sie einen Index haben.
+ */
+bool ListModel::findText(const ppl7::String& text, size_t& row) const
+{
+	size_t rows=rowCount();
+	for (size_t i=0;i < rows;i++) {
+		if (data(i) == text) {
+			row=i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ListModel::findIdentifier(const ppl7::String& identifier, size_t& row) const
+{
+	size_t rows=rowCount();
+	for (size_t i=0;i < rows;i++) {
+		if (this->identifier(i) == identifier) {
+			row=i;
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t StringHash::operator()(const ppl7::String& str) const
+{
+	// FNV-1a
+	const unsigned char* p=(const unsigned char*)str.getPtr();
+	size_t size=str.size();
+	uint64_t hash=14695981039346656037ULL;
+	for (size_t i=0;i < size;i++) {
+		hash^=p[i];
+		hash*=1099511628211ULL;
+	}
+	return (size_t)hash;
+}
+
+ListWidget::ItemModel::ItemModel()
+{
+	sorted=false;
+	orderDirty=false;
+	sortOrder=SortOrder::AscendingOrder;
+	revision=0;
+}
+
+/*!\brief Sortierschlüssel zu einem Text
+ *
+ * \desc
+ * Der Schlüssel wird beim Hinzufügen einmal berechnet, damit beim Einsortieren nur
+ * noch fertige Schlüssel verglichen werden.
+ */
+ppl7::String ListWidget::ItemModel::collationKey(const ppl7::String& text)
+{
+	return text.toLowerCase();
+}
+
+int ListWidget::ItemModel::compare(size_t a, size_t b) const
+{
+	if (collationKeys[a] < collationKeys[b]) return -1;
+	if (collationKeys[b] < collationKeys[a]) return 1;
+	return items[a].text.strcmp(items[b].text);
+}
+
+bool ListWidget::ItemModel::less(size_t a, size_t b) const
+{
+	int cmp=compare(a, b);
+	if (cmp != 0) return sortOrder == SortOrder::DescendingOrder ? cmp > 0 : cmp < 0;
+	// Gleiche Texte bleiben in der Reihenfolge, in der sie hinzugefügt wurden
+	return a < b;
+}
+
+/*!\brief Angezeigte Zeile in Position in \ref items umrechnen
+ */
+size_t ListWidget::ItemModel::itemRow(size_t row) const
+{
+	if (sorted) return order[row];
+	return row;
+}
+
+size_t ListWidget::ItemModel::displayRow(size_t item) const
+{
+	if (!sorted) return item;
+	if (orderDirty) {
+		// Während eines Updates ist die Reihenfolge noch nicht sortiert
+		for (size_t i=0;i < order.size();i++) {
+			if (order[i] == item) return i;
+		}
+		return order.size();
+	}
+	std::vector<size_t>::const_iterator it=std::lower_bound(order.begin(), order.end(), item,
+		[this](size_t a, size_t b) { return less(a, b); });
+	return (size_t)(it - order.begin());
+}
+
+size_t ListWidget::ItemModel::rowCount() const
+{
+	return items.size();
+}
+
+ppl7::String ListWidget::ItemModel::data(size_t row) const
+{
+	return items[itemRow(row)].text;
+}
+
+ppl7::String ListWidget::ItemModel::identifier(size_t row) const
+{
+	return items[itemRow(row)].identifier;
+}
+
+bool ListWidget::ItemModel::findText(const ppl7::String& text, size_t& row) const
+{
+	Index::const_iterator it=textIndex.find(text);
+	if (it == textIndex.end()) return false;
+	row=displayRow(it->second);
+	return true;
+}
+
+bool ListWidget::ItemModel::findIdentifier(const ppl7::String& identifier, size_t& row) const
+{
+	Index::const_iterator it=identifierIndex.find(identifier);
+	if (it == identifierIndex.end()) return false;
+	row=displayRow(it->second);
+	return true;
+}
+
+/*!\brief Zeile in einen Index aufnehmen
+ *
+ * \desc
+ * Der Index zeigt bei mehrfach vorkommenden Schlüsseln immer auf die erste Zeile.
+ */
+void ListWidget::ItemModel::indexRow(Index& index, const ppl7::String& key, size_t row)
+{
+	std::pair<Index::iterator, bool> res=index.insert(std::pair<ppl7::String, size_t>(key, row));
+	if (!res.second && row < res.first->second) res.first->second=row;
+}
+
+void ListWidget::ItemModel::unindexRow(Index& index, const ppl7::String& key, size_t row, bool is_text)
+{
+	Index::iterator it=index.find(key);
+	if (it == index.end() || it->second != row) return;
+	for (size_t i=row + 1;i < items.size();i++) {
+		if ((is_text ? items[i].text : items[i].identifier) == key) {
+			it->second=i;
+			return;
+		}
+	}
+	index.erase(it);
+}
+
+/*!\brief Eintrag hinzufügen
+ *
+ * \desc
+ * Bei aktivierter Sortierung wird die Position per binärer Suche bestimmt, es sind
+ * also nur O(log n) Vergleiche nötig. Ist \p keep_sorted false, wird der Eintrag
+ * hinten angehängt und erst mit \ref resort einsortiert.
+ *
+ * \return Angezeigte Zeile des neuen Eintrags
+ */
+size_t ListWidget::ItemModel::append(const ppl7::String& text, const ppl7::String& identifier, bool keep_sorted)
+{
+	ListWidgetItem item;
+	item.text=text;
+	item.identifier=identifier;
+	item.index=items.size();
+	items.push_back(item);
+	revision++;
+	collationKeys.push_back(collationKey(text));
+	indexRow(textIndex, text, item.index);
+	indexRow(identifierIndex, identifier, item.index);
+	if (!sorted) return item.index;
+	if (!keep_sorted || orderDirty) {
+		orderDirty=true;
+		order.push_back(item.index);
+		return order.size() - 1;
+	}
+	std::vector<size_t>::iterator it=std::upper_bound(order.begin(), order.end(), item.index,
+		[this](size_t a, size_t b) { return less(a, b); });
+	it=order.insert(it, item.index);
+	return (size_t)(it - order.begin());
+}
+
+void ListWidget::ItemModel::erase(size_t row)
+{
+	if (row >= items.size()) return;
+	size_t item=itemRow(row);
+	if (sorted) {
+		order.erase(order.begin() + row);
+		for (size_t i=0;i < order.size();i++) {
+			if (order[i] > item) order[i]--;
+		}
+	}
+	unindexRow(textIndex, items[item].text, item, true);
+	unindexRow(identifierIndex, items[item].identifier, item, false);
+	items.erase(items.begin() + item);
+	revision++;
+	collationKeys.erase(collationKeys.begin() + item);
+	// Alle folgenden Zeilen rücken eine Position nach vorne
+	for (size_t i=item;i < items.size();i++) {
+		items[i].index=i;
+		Index::iterator it=textIndex.find(items[i].text);
+		if (it->second == i + 1) it->second=i;
+		it=identifierIndex.find(items[i].identifier);
+		if (it->second == i + 1) it->second=i;
+	}
+}
+
+void ListWidget::ItemModel::clear()
+{
+	items.clear();
+	revision++;
+	collationKeys.clear();
+	order.clear();
+	orderDirty=false;
+	textIndex.clear();
+	identifierIndex.clear();
+}
+
+void ListWidget::ItemModel::reindex()
+{
+	textIndex.clear();
+	identifierIndex.clear();
+	collationKeys.resize(items.size());
+	for (size_t i=0;i < items.size();i++) {
+		items[i].index=i;
+		collationKeys[i]=collationKey(items[i].text);
+		indexRow(textIndex, items[i].text, i);
+		indexRow(identifierIndex, items[i].identifier, i);
+	}
+	resort();
+}
+
+void ListWidget::ItemModel::setSorted(bool enable)
+{
+	if (enable == sorted) return;
+	sorted=enable;
+	resort();
+}
+
+/*!\brief Sortierte Reihenfolge komplett neu aufbauen
+ */
+void ListWidget::ItemModel::resort()
+{
+	orderDirty=false;
+	order.clear();
+	if (!sorted) return;
+	order.resize(items.size());
+	for (size_t i=0;i < order.size();i++) order[i]=i;
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return less(a, b); });
+}
+
+bool ListWidget::ItemModel::isSorted() const
+{
+	return sorted;
+}
+
+bool ListWidget::ItemModel::isOrderDirty() const
+{
+	return orderDirty;
+}
+
+/*!\brief Richtung der sortierten Anzeige setzen
+ */
+void ListWidget::ItemModel::setSortOrder(SortOrder sort)
+{
+	if (sort == sortOrder) return;
+	sortOrder=sort;
+	resort();
+}
+
+/*!\brief Einträge dauerhaft umsortieren
+ *
+ * \desc
+ * Im Gegensatz zu \ref setSorted wird die Reihenfolge in \ref items selbst geändert.
+ * Einträge mit gleichem Text bleiben dabei erhalten. \p item wird auf die neue
+ * Position des Eintrags umgerechnet.
+ */
+void ListWidget::ItemModel::sortItems(SortOrder sort, size_t& item)
+{
+	std::vector<size_t> perm(items.size());
+	for (size_t i=0;i < perm.size();i++) perm[i]=i;
+	// Die Richtung gilt auch für eine später eingeschaltete sortierte Anzeige
+	sortOrder=sort;
+	std::sort(perm.begin(), perm.end(), [this](size_t a, size_t b) { return less(a, b); });
+	std::vector<ListWidgetItem> sorted_items;
+	sorted_items.reserve(items.size());
+	size_t new_item=item;
+	for (size_t i=0;i < perm.size();i++) {
+		if (perm[i] == item) new_item=i;
+		sorted_items.push_back(items[perm[i]]);
+	}
+	items.swap(sorted_items);
+	revision++;
+	item=new_item;
+	reindex();
+}
+
 ListWidget::ListWidget(int x, int y, int width, int height)
 	: ppltk::Frame(x, y, width, height)
 {
 	setClientOffset(2, 2, 2, 2);
+	model=&itemModel;
 	scrollbar=NULL;
 	myCurrentIndex=0;
 	scrollbar=new Scrollbar(width - 29, 0, 29, height - 4);
 	scrollbar->setEventHandler(this);
 	this->addChild(scrollbar);
 	mouseOverIndex=-1;
+	updateDepth=0;
+	itemListRevision=(size_t)-1;
 	visibleItems=height / 30;
 	scrollbar->setVisible(false);
 	scrollbar->setVisibleItems(visibleItems);
-	sortingEnabled=false;
 
 	const ppltk::WidgetStyle& style=ppltk::GetWidgetStyle();
 	setBackgroundColor(style.listBackgroundColor);
@@ -71,40 +381,28 @@ ppl7::String ListWidget::currentIdentifier() const
 void ListWidget::setCurrentText(const ppl7::String& text)
 {
 	if (text != myCurrentText) {
-		std::list<ListWidgetItem>::iterator it;
-		for (it=items.begin();it != items.end();++it) {
-			if ((*it).text == text) {
-				myCurrentText=(*it).text;
-				myCurrentIdentifier=(*it).identifier;
-				myCurrentIndex=(*it).index;
-				size_t start=scrollbar->position();
-				if (start + visibleItems <= myCurrentIndex) {
-					scrollbar->setPosition(myCurrentIndex);
-				}
-				needsRedraw();
-				return;
-			}
-		}
+		size_t row;
+		if (model->findText(text, row)) setCurrentIndex(row);
 	}
 }
 
+void ListWidget::setCurrentIdentifier(const ppl7::String& identifier)
+{
+	size_t row;
+	if (model->findIdentifier(identifier, row)) setCurrentIndex(row);
+}
+
 void ListWidget::setCurrentIndex(size_t index)
 {
-	if (index >= items.size()) return;
-	std::list<ListWidgetItem>::iterator it;
-	for (it=items.begin();it != items.end();++it) {
-		if ((*it).index == index) {
-			myCurrentIndex=index;
-			size_t start=scrollbar->position();
-			if (start + visibleItems <= index) {
-				scrollbar->setPosition(index);
-			}
-			myCurrentText=(*it).text;
-			myCurrentIdentifier=(*it).identifier;
-			needsRedraw();
-			return;
-		}
+	if (index >= model->rowCount()) return;
+	myCurrentIndex=index;
+	size_t start=scrollbar->position();
+	if (start + visibleItems <= index) {
+		scrollbar->setPosition((int)index);
 	}
+	myCurrentText=model->data(index);
+	myCurrentIdentifier=model->identifier(index);
+	needsRedraw();
 }
 
 size_t ListWidget::currentIndex() const
@@ -114,67 +412,174 @@ size_t ListWidget::currentIndex() const
 
 void ListWidget::add(const ppl7::String& text, const ppl7::String& identifier)
 {
-	ListWidgetItem item;
-	item.text=text;
-	item.identifier=identifier;
-	item.index=items.size();
-	items.push_back(item);
-	if (items.size() == 1) setCurrentIndex(0);
-	scrollbar->setSize((int)items.size());
-	if (items.size() > visibleItems) scrollbar->setVisible(true);
-	else scrollbar->setVisible(false);
-	if (sortingEnabled) updateSortedItems();
+	if (updateDepth > 0) {
+		itemModel.append(text, identifier, false);
+		return;
+	}
+	size_t row=itemModel.append(text, identifier);
+	if (model != &itemModel) return;
+	if (itemModel.items.size() == 1) setCurrentIndex(0);
+	else if (row <= myCurrentIndex) myCurrentIndex++;
+	updateScrollbar();
 	needsRedraw();
 }
 
 void ListWidget::remove(size_t index)
 {
-	std::list<ListWidgetItem>::iterator it;
-	for (it=items.begin();it != items.end();++it) {
-		if ((*it).index == index) {
-			items.erase(it);
-			break;
-		}
-	}
-	scrollbar->setSize((int)items.size());
-	if (items.size() > visibleItems) scrollbar->setVisible(true);
-	else scrollbar->setVisible(false);
-	if (sortingEnabled) updateSortedItems();
-	needsRedraw();
+	if (index >= itemModel.items.size()) return;
+	itemModel.erase(index);
+	if (model != &itemModel) return;
+	if (index < myCurrentIndex) myCurrentIndex--;
+	if (updateDepth == 0) modelChanged();
 }
 
 
 void ListWidget::remove(const ppl7::String& identifier)
 {
-	std::list<ListWidgetItem>::iterator it;
-	for (it=items.begin();it != items.end();++it) {
-		if ((*it).identifier == identifier) {
-			items.erase(it);
-			break;
-		}
-	}
-	scrollbar->setSize((int)items.size());
-	if (items.size() > visibleItems) scrollbar->setVisible(true);
-	else scrollbar->setVisible(false);
-	if (sortingEnabled) updateSortedItems();
-	needsRedraw();
+	size_t row;
+	if (itemModel.findIdentifier(identifier, row)) remove(row);
 }
 
 void ListWidget::clear()
 {
 	myCurrentText.clear();
 	myCurrentIdentifier.clear();
-	items.clear();
-	sorted_items.clear();
+	myCurrentIndex=0;
+	itemModel.clear();
+	model=&itemModel;
 	scrollbar->setPosition(0);
-	scrollbar->setSize(0);
-	scrollbar->setVisible(false);
+	updateScrollbar();
 	needsRedraw();
 }
 
+/*!\brief Mehrere Änderungen zusammenfassen
+ *
+ * \desc
+ * Bis zum passenden \ref endUpdate werden bei \ref add und \ref remove weder die
+ * Scrollbar aktualisiert noch die Einträge einsortiert oder neu gezeichnet. Das
+ * geschieht einmalig in \ref endUpdate. Aufrufe können verschachtelt werden.
+ */
+void ListWidget::beginUpdate()
+{
+	updateDepth++;
+}
+
+void ListWidget::endUpdate()
+{
+	if (updateDepth == 0) return;
+	updateDepth--;
+	if (updateDepth > 0) return;
+	if (itemModel.isOrderDirty()) {
+		// Nur neu hinzugefügte Einträge müssen einsortiert werden
+		bool has_current=(model == &itemModel && myCurrentIndex < itemModel.items.size());
+		size_t item=0;
+		if (has_current) item=itemModel.itemRow(myCurrentIndex);
+		itemModel.resort();
+		if (has_current) myCurrentIndex=itemModel.displayRow(item);
+	}
+	if (model != &itemModel) return;
+	modelChanged();
+}
+
+void ListWidget::addItems(const std::vector<ListWidgetItem>& items)
+{
+	beginUpdate();
+	for (auto it=items.begin();it != items.end();++it) {
+		add(it->text, it->identifier);
+	}
+	endUpdate();
+}
+
+/*!\brief Mit \ref add hinzugefügte Einträge
+ *
+ * \desc
+ * Die Einträge stehen in der Reihenfolge, in der sie hinzugefügt wurden. Bei
+ * eingeschalteter Sortierung entspricht der Index daher nicht der angezeigten Zeile,
+ * \c items()[currentIndex()] ist dann ein anderer Eintrag. Für Zeilennummern
+ * wie \ref currentIndex ist \ref itemAt zu verwenden.
+ */
+const std::vector<ListWidget::ListWidgetItem>& ListWidget::items() const
+{
+	return itemModel.items;
+}
+
+/*!rief Mit \ref add hinzugefügte Einträge als Liste
+ *
+ * \desc
+ * Liefert dieselben Einträge wie \ref items. Die Liste wird nach jeder Änderung
+ * beim nächsten Aufruf einmal neu aufgebaut, das kostet O(n). Neuer Code sollte
+ * daher \ref items verwenden.
+ */
 const std::list<ListWidget::ListWidgetItem>& ListWidget::getItems() const
 {
-	return items;
+	if (itemListRevision != itemModel.revision) {
+		itemList.assign(itemModel.items.begin(), itemModel.items.end());
+		itemListRevision=itemModel.revision;
+	}
+	return itemList;
+}
+
+/*!\brief Eintrag in einer angezeigten Zeile
+ *
+ * \param row Zeile in der Anzeige, wie sie \ref currentIndex liefert
+ * \return Eintrag, unter Berücksichtigung der Sortierung
+ * \exception OutOfBoundsEception Die Zeile existiert nicht
+ */
+const ListWidget::ListWidgetItem& ListWidget::itemAt(size_t row) const
+{
+	if (row >= itemModel.items.size()) throw ppl7::OutOfBoundsEception("Row %zu does not exist", row);
+	return itemModel.items[itemModel.itemRow(row)];
+}
+
+/*!\brief Datenquelle setzen
+ *
+ * \desc
+ * Das ListWidget fragt beim Zeichnen nur die sichtbaren Zeilen beim Model ab, die
+ * Anzahl der Zeilen spielt daher keine Rolle. Das Model bleibt im Besitz des Aufrufers
+ * und muss so lange existieren, wie es im ListWidget gesetzt ist. Nach Änderungen an
+ * den Daten muss \ref modelChanged aufgerufen werden. Mit NULL werden wieder die mit
+ * \ref add hinzugefügten Einträge angezeigt.
+ */
+void ListWidget::setModel(ListModel* model)
+{
+	if (!model) model=&itemModel;
+	this->model=model;
+	myCurrentIndex=0;
+	myCurrentText.clear();
+	myCurrentIdentifier.clear();
+	mouseOverIndex=-1;
+	scrollbar->setPosition(0);
+	if (model->rowCount() > 0) setCurrentIndex(0);
+	modelChanged();
+}
+
+ListModel* ListWidget::getModel() const
+{
+	if (model == &itemModel) return NULL;
+	return model;
+}
+
+void ListWidget::modelChanged()
+{
+	size_t rows=model->rowCount();
+	if (myCurrentIndex >= rows) {
+		myCurrentIndex=0;
+		myCurrentText.clear();
+		myCurrentIdentifier.clear();
+	} else {
+		myCurrentText=model->data(myCurrentIndex);
+		myCurrentIdentifier=model->identifier(myCurrentIndex);
+	}
+	updateScrollbar();
+	needsRedraw();
+}
+
+void ListWidget::updateScrollbar()
+{
+	size_t rows=model->rowCount();
+	scrollbar->setSize((int)rows);
+	if (rows > visibleItems) scrollbar->setVisible(true);
+	else scrollbar->setVisible(false);
 }
 
 ppl7::String ListWidget::widgetType() const
@@ -184,8 +589,30 @@ ppl7::String ListWidget::widgetType() const
 
 void ListWidget::paint(ppl7::grafix::Drawable& draw)
 {
-	ppltk::Frame::paint(draw);
+	paint(draw, ppl7::grafix::Rect(0, 0, draw.width(), draw.height()));
+}
+
+bool ListWidget::canPaintPartially() const
+{
+	return true;
+}
+
+void ListWidget::paint(ppl7::grafix::Drawable& draw, const ppl7::grafix::Rect& clip)
+{
 	const ppltk::WidgetStyle& style=ppltk::GetWidgetStyle();
+	ppl7::grafix::Rect cr=clientRect();
+	//ppl7::grafix::Drawable client=draw.getDrawable(1, 1, draw.width() - 2, draw.height() - 2);
+	ppl7::grafix::Drawable client=clientDrawable(draw);
+	// Clip-Bereich in Client-Koordinaten
+	int clip_x1=clip.left() - cr.left();
+	int clip_y1=clip.top() - cr.top();
+	int clip_y2=clip_y1 + clip.height();
+	if (clip.width() < draw.width() || clip.height() < draw.height()) {
+		// Nur einzelne Zeilen, der Rahmen bleibt stehen
+		client.fillRect(clip_x1, clip_y1, clip_x1 + clip.width(), clip_y2, backgroundColor());
+	} else {
+		ppltk::Frame::paint(draw);
+	}
 	//int h=height()-1;
 	int y=0;
 	ppl7::grafix::Font myFont=style.buttonFont;
@@ -194,33 +621,33 @@ void ListWidget::paint(ppl7::grafix::Drawable& draw)
 	ppl7::grafix::Color mouseoverSelectionColor=style.inputSelectedBackgroundColor * 1.3f;
 	ppl7::grafix::Color mouseoverColor=style.listBackgroundColor * 1.7f;
 	ppl7::grafix::Color dividerColor=style.listBackgroundColor * 0.8f;
-	std::list<ListWidgetItem>::iterator it;
 	myFont.setColor(style.labelFontColor);
 	myFont.setOrientation(ppl7::grafix::Font::TOP);
-	int start=scrollbar->position();
-	//ppl7::grafix::Drawable client=draw.getDrawable(1, 1, draw.width() - 2, draw.height() - 2);
-	ppl7::grafix::Drawable client=clientDrawable(draw);
+	size_t start=scrollbar->position();
 	int w=width() - 2;
 	if (scrollbar->isVisible()) w-=29;
-	int c=0;
-	for (it=items.begin();it != items.end();++it) {
-		if (start <= c) {
-			if (c == mouseOverIndex && (*it).index != myCurrentIndex)
-				client.fillRect(0, y, w, y + 30, mouseoverColor);
-			else if (c == mouseOverIndex && (*it).index == myCurrentIndex)
-				client.fillRect(0, y, w, y + 30, mouseoverSelectionColor);
-			else if ((*it).index == myCurrentIndex)
-				client.fillRect(0, y, w, y + 30, selectionColor);
-			else if (c & 1)
-				client.fillRect(0, y, w, y + 30, unevenColor);
-			else
-				client.fillRect(0, y, w, y + 30, style.listBackgroundColor);
-			ppl7::grafix::Size s=myFont.measure((*it).text);
-			client.print(myFont, 4, y + ((30 - s.height) >> 1), (*it).text);
-			client.line(0, y + 29, w, y + 29, dividerColor);
-			y+=30;
-		}
-		c++;
+	// Nur die Zeilen im Clip-Bereich beim Model abfragen
+	size_t rows=model->rowCount();
+	size_t first=0;
+	if (clip_y1 > 0) first=clip_y1 / 30;
+	y=(int)first * 30;
+	for (size_t c=start + first;c < rows;c++) {
+		if (y >= clip_y2 || y >= client.height()) break;
+		if ((int)c == mouseOverIndex && c != myCurrentIndex)
+			client.fillRect(0, y, w, y + 30, mouseoverColor);
+		else if ((int)c == mouseOverIndex && c == myCurrentIndex)
+			client.fillRect(0, y, w, y + 30, mouseoverSelectionColor);
+		else if (c == myCurrentIndex)
+			client.fillRect(0, y, w, y + 30, selectionColor);
+		else if (c & 1)
+			client.fillRect(0, y, w, y + 30, unevenColor);
+		else
+			client.fillRect(0, y, w, y + 30, style.listBackgroundColor);
+		ppl7::String text=model->data(c);
+		ppl7::grafix::Size s=myFont.measure(text);
+		client.print(myFont, 4, y + ((30 - s.height) >> 1), text);
+		client.line(0, y + 29, w, y + 29, dividerColor);
+		y+=30;
 	}
 }
 
@@ -237,7 +664,7 @@ void ListWidget::mouseDownEvent(ppltk::MouseEvent* event)
 {
 	if (event->p.x < width() - 29 && event->widget() == this) {
 		size_t index=scrollbar->position() + event->p.y / 30;
-		if (index > items.size()) return;
+		if (index >= model->rowCount()) return;
 		setCurrentIndex((size_t)index);
 		ppltk::Event ev(ppltk::Event::ValueChanged);
 		ev.setWidget(this);
@@ -265,11 +692,25 @@ void ListWidget::mouseMoveEvent(ppltk::MouseEvent* event)
 {
 	if (event->p.x < width() - 30 && event->widget() == this) {
 		//printf ("x=%d\n",event->p.x);
-		mouseOverIndex=scrollbar->position() + event->p.y / 30;
-		this->needsRedraw();
+		int index=scrollbar->position() + event->p.y / 30;
+		if (index != mouseOverIndex) {
+			rowNeedsRedraw(mouseOverIndex);
+			mouseOverIndex=index;
+			rowNeedsRedraw(mouseOverIndex);
+		}
 	}
 }
 
+void ListWidget::rowNeedsRedraw(int index)
+{
+	int row=index - scrollbar->position();
+	if (index < 0 || row < 0 || row > (int)visibleItems) return;
+	ppl7::grafix::Rect cr=clientRect();
+	int w=width() - 2;
+	if (scrollbar->isVisible()) w-=29;
+	needsRedraw(ppl7::grafix::Rect(cr.left(), cr.top() + row * 30, w, 30));
+}
+
 
 void ListWidget::lostFocusEvent(ppltk::FocusEvent* event)
 {
@@ -288,62 +729,58 @@ void ListWidget::lostFocusEvent(ppltk::FocusEvent* event)
 
 bool ListWidget::hasIdentifier(const ppl7::String& identifier) const
 {
-	for (auto it=items.begin();it != items.end();++it) {
-		if (it->identifier == identifier) return true;
-	}
-	return false;
+	size_t row;
+	return model->findIdentifier(identifier, row);
 }
 
 bool ListWidget::hasText(const ppl7::String& text) const
 {
-	for (auto it=items.begin();it != items.end();++it) {
-		if (it->text == text) return true;
-	}
-	return false;
-}
-
-void ListWidget::updateSortedItems()
-{
-	sorted_items.clear();
-	for (auto it=items.begin();it != items.end();++it) {
-		sorted_items.insert(std::pair<ppl7::String, ListWidgetItem&>(it->text, *it));
-	}
-
+	size_t row;
+	return model->findText(text, row);
 }
 
+/*!\brief Sortierte Anzeige ein- oder ausschalten
+ *
+ * \desc
+ * Bei aktivierter Sortierung werden die mit \ref add hinzugefügten Einträge nach
+ * ihrem Text sortiert angezeigt, neue Einträge werden direkt einsortiert. Die
+ * Reihenfolge in \ref items bleibt unverändert. Zeilennummern wie
+ * \ref currentIndex beziehen sich immer auf die Anzeige, den Eintrag zu einer
+ * angezeigten Zeile liefert \ref itemAt. Die Richtung legt \ref sortItems fest.
+ */
 void ListWidget::setSortingEnabled(bool enable)
 {
-	sortingEnabled=enable;
-	if (sortingEnabled) updateSortedItems();
-	needsRedraw();
+	if (enable == itemModel.isSorted()) return;
+	bool has_current=(model == &itemModel && myCurrentIndex < itemModel.items.size());
+	size_t item=0;
+	if (has_current) item=itemModel.itemRow(myCurrentIndex);
+	itemModel.setSorted(enable);
+	if (has_current) myCurrentIndex=itemModel.displayRow(item);
+	if (model == &itemModel) modelChanged();
 }
 
 bool ListWidget::isSortingEnabled() const
 {
-	return sortingEnabled;
+	return itemModel.isSorted();
 }
 
+/*!\brief Einträge sortieren
+ *
+ * \desc
+ * Ist die sortierte Anzeige mit \ref setSortingEnabled eingeschaltet, wird nur ihre
+ * Richtung geändert, die Reihenfolge in \ref items bleibt erhalten. Andernfalls
+ * werden die Einträge selbst umsortiert. Der aktuelle Eintrag bleibt ausgewählt.
+ */
 void ListWidget::sortItems(SortOrder sort)
 {
-	size_t current=currentIndex();
-	std::map<ppl7::String, ListWidgetItem> sorted;
-	for (auto it=items.begin();it != items.end();++it) {
-		sorted.insert(std::pair<ppl7::String, ListWidgetItem>(it->text, *it));
-	}
-	items.clear();
-	if (sort == SortOrder::AscendingOrder) {
-		for (auto it=sorted.begin();it != sorted.end();++it) {
-			it->second.index=items.size();
-			items.push_back(it->second);
-		}
-	} else {
-		for (auto it=sorted.rbegin();it != sorted.rend();++it) {
-			it->second.index=items.size();
-			items.push_back(it->second);
-		}
-	}
-	setCurrentIndex(current);
-	needsRedraw();
+	if (model != &itemModel) return;
+	bool has_current=(myCurrentIndex < itemModel.items.size());
+	size_t item=(size_t)-1;
+	if (has_current) item=itemModel.itemRow(myCurrentIndex);
+	if (itemModel.isSorted()) itemModel.setSortOrder(sort);
+	else itemModel.sortItems(sort, item);
+	if (has_current) myCurrentIndex=itemModel.displayRow(item);
+	modelChanged();
 }
 
 
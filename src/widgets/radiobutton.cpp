@@ -59,6 +59,12 @@ ppl7::String RadioButton::widgetType() const
 	return ppl7::String("RadioButton");
 }
 
+bool RadioButton::isOpaque() const
+{
+	// Der Bereich links vom Text wird nicht vom Hintergrund überdeckt
+	return false;
+}
+
 bool RadioButton::checked() const
 {
 	return ischecked;
@@ -80,7 +80,7 @@ void Scrollbar::setSize(int size)
 	if (size != this->mySize && size >= 0) {
 		this->mySize=size;
 		if (pos > size) pos=size;
-		needsRedraw();
+		indicatorNeedsRedraw();
 	}
 }
 
@@ -89,14 +89,14 @@ void Scrollbar::setPosition(int position)
 	if (position != pos && position < mySize && position >= 0) {
 		if (position > mySize - myVisibleItems) position=mySize - myVisibleItems;
 		pos=position;
-		needsRedraw();
+		indicatorNeedsRedraw();
 	}
 }
 
 void Scrollbar::setVisibleItems(int items)
 {
 	myVisibleItems=items;
-	needsRedraw();
+	indicatorNeedsRedraw();
 }
 
 int Scrollbar::position() const
@@ -114,15 +114,44 @@ int Scrollbar::size() const
 	return mySize;
 }
 
-void Scrollbar::paint(ppl7::grafix::Drawable& draw)
+void Scrollbar::paintSlider(ppl7::grafix::Drawable& draw, const ppl7::grafix::Rect& r1)
 {
 	const ppltk::WidgetStyle& style=ppltk::GetWidgetStyle();
 	ppl7::grafix::Color light=style.buttonBackgroundColor * 1.8f;
 	ppl7::grafix::Color shadow=style.buttonBackgroundColor * 0.4f;
 	ppl7::grafix::Color shade1=style.buttonBackgroundColor * 1.05f;
 	ppl7::grafix::Color shade2=style.buttonBackgroundColor * 0.85f;
-	ppl7::grafix::Drawable indicator=draw.getDrawable(0, 23, draw.width(), draw.height() - 24);
-	int w=indicator.width();
+	int w=draw.width();
+	draw.colorGradient(r1, shade1, shade2, 1);
+	draw.line(0, r1.y1, w, r1.y1, light);
+	draw.line(0, r1.y1, 0, r1.y2, light);
+	draw.line(0, r1.y2, w, r1.y2, shadow);
+	draw.line(w, r1.y1, w, r1.y2, shadow);
+}
+
+ppl7::grafix::Rect Scrollbar::indicatorRect() const
+{
+	// Bereich zwischen den beiden Buttons
+	ppl7::grafix::Rect r;
+	r.setCoords(0, 23, width(), height() - 24);
+	return r;
+}
+
+void Scrollbar::paint(ppl7::grafix::Drawable& draw)
+{
+	paint(draw, draw.rect());
+}
+
+bool Scrollbar::canPaintPartially() const
+{
+	return true;
+}
+
+void Scrollbar::paint(ppl7::grafix::Drawable& draw, const ppl7::grafix::Rect& clip)
+{
+	const ppltk::WidgetStyle& style=ppltk::GetWidgetStyle();
+	ppl7::grafix::Rect ir=indicatorRect();
+	ppl7::grafix::Drawable indicator=draw.getDrawable(ir);
 	//int h=indicator.height()-1;
 	ppl7::grafix::Rect r1=indicator.rect();
 
@@ -143,19 +172,47 @@ void Scrollbar::paint(ppl7::grafix::Drawable& draw)
 
 	}
 	slider_pos=r1;
-	slider_pos.y1+=23;
-	slider_pos.y2+=23;
+	slider_pos.y1+=ir.top();
+	slider_pos.y2+=ir.top();
+
+	// Nur die Zeilen des Indikators neu zeichnen, die im Clip-Bereich liegen.
+	// Die Buttons sind eigene Widgets und bleiben unberührt.
+	int top=clip.top() - ir.top();
+	int bottom=top + clip.height();
+	if (top < 0) top=0;
+	if (bottom > indicator.height()) bottom=indicator.height();
+	if (top >= bottom) return;
+	ppl7::grafix::Drawable area=indicator.getDrawable(ppl7::grafix::Rect(0, top, indicator.width(), bottom - top));
 
 	ppl7::grafix::Color scrollarea=style.windowBackgroundColor * 1.2f;
-	indicator.cls(scrollarea);
-	indicator.colorGradient(r1, shade1, shade2, 1);
-	indicator.line(0, r1.y1, w, r1.y1, light);
-	indicator.line(0, r1.y1, 0, r1.y2, light);
-	indicator.line(0, r1.y2, w, r1.y2, shadow);
-	indicator.line(w, r1.y1, w, r1.y2, shadow);
-
-	//ppltk::Widget::paint(draw);
-	//draw.fillRect(0,y1,draw.width(),y2,style.frameBorderColorLight);
+	area.cls(scrollarea);
+	if (r1.y2 < top || r1.y1 >= bottom) return;
+	// Der Schieber hängt nur von seiner Größe und den Farben ab und wird daher
+	// aus dem ChromeCache kopiert
+	bool created;
+	ppl7::grafix::Size size(indicator.width(), r1.y2 - r1.y1 + 1);
+	ppltk::ChromeCache::Key key("ScrollbarSlider", size, 0, style.buttonBackgroundColor, scrollarea);
+	ppl7::grafix::Drawable* chrome=ppltk::GetWindowManager()->chromeCache().lookup(key, created);
+	if (!chrome) {
+		ppl7::grafix::Rect r2=r1;
+		r2.y1-=top;
+		r2.y2-=top;
+		paintSlider(area, r2);
+	} else {
+		if (created) {
+			ppl7::grafix::Rect r2=r1;
+			r2.y1=0;
+			r2.y2=r1.y2 - r1.y1;
+			chrome->cls(scrollarea);
+			paintSlider(*chrome, r2);
+		}
+		area.blt(*chrome, 0, r1.y1 - top);
+	}
+}
+
+void Scrollbar::indicatorNeedsRedraw()
+{
+	needsRedraw(indicatorRect());
 }
 
 void Scrollbar::mouseDownEvent(ppltk::MouseEvent* event)
@@ -171,7 +228,7 @@ void Scrollbar::mouseDownEvent(ppltk::MouseEvent* event)
 			pos-=d;
 			if (pos < 0) pos=0;
 			//ppl7::PrintDebug("pos=%d\n",pos);
-			needsRedraw();
+			indicatorNeedsRedraw();
 			ppltk::Event ev(ppltk::Event::ValueChanged);
 			ev.setWidget(this);
 			valueChangedEvent(&ev, pos);
@@ -189,7 +246,7 @@ void Scrollbar::mouseDownEvent(ppltk::MouseEvent* event)
 			if (pos >= mySize - myVisibleItems) pos=mySize - myVisibleItems;
 			if (pos < 0) pos=0;
 			//ppl7::PrintDebug("pos=%d\n",pos);
-			needsRedraw();
+			indicatorNeedsRedraw();
 			ppltk::Event ev(ppltk::Event::ValueChanged);
 			ev.setWidget(this);
 			valueChangedEvent(&ev, pos);
@@ -208,7 +265,7 @@ void Scrollbar::mouseDownEvent(ppltk::MouseEvent* event)
 			if (d < 1) d=1;
 			pos-=d;
 			if (pos < 0) pos=0;
-			needsRedraw();
+			indicatorNeedsRedraw();
 			ppltk::Event ev(ppltk::Event::ValueChanged);
 			ev.setWidget(this);
 			valueChangedEvent(&ev, pos);
@@ -218,7 +275,7 @@ void Scrollbar::mouseDownEvent(ppltk::MouseEvent* event)
 			pos+=d;
 			if (pos >= mySize) pos=mySize - myVisibleItems;
 			if (pos < 0) pos=0;
-			needsRedraw();
+			indicatorNeedsRedraw();
 			ppltk::Event ev(ppltk::Event::ValueChanged);
 			ev.setWidget(this);
 			valueChangedEvent(&ev, pos);
@@ -251,7 +308,7 @@ void Scrollbar::mouseMoveEvent(ppltk::MouseEvent* event)
 			if (v >= mySize - myVisibleItems) v=mySize - myVisibleItems;
 			if (v < 0) v=0;
 			pos=v;
-			needsRedraw();
+			indicatorNeedsRedraw();
 			ppltk::Event ev(ppltk::Event::ValueChanged);
 			ev.setWidget(this);
 			valueChangedEvent(&ev, pos);
@@ -275,14 +332,14 @@ void Scrollbar::mouseWheelEvent(ppltk::MouseEvent* event)
 		pos+=d;
 		if (pos >= mySize - myVisibleItems) pos=mySize - myVisibleItems;
 		if (pos < 0) pos=0;
-		needsRedraw();
+		indicatorNeedsRedraw();
 		ppltk::Event ev(ppltk::Event::ValueChanged);
 		ev.setWidget(this);
 		valueChangedEvent(&ev, pos);
 	} else if (event->wheel.y > 0 && pos > 0) {
 		pos-=d;
 		if (pos < 0) pos=0;
-		needsRedraw();
+		indicatorNeedsRedraw();
 		ppltk::Event ev(ppltk::Event::ValueChanged);
 		ev.setWidget(this);
 		valueChangedEvent(&ev, pos);
@@ -0,0 +1,353 @@
+/*******************************************************************************
+ * This file is part of "Patrick's Programming Library Toolkit", ppltk.
+ * Web: https://github.com/pfedick/ppltk
+ *
+ *******************************************************************************
+ * Copyright (c) 2024, Patrick Fedick <patrick@pfp.de>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/*
+ * Tests für die inkrementellen Datenstrukturen von ppltk
+ *
+ * Läuft ohne Videogerät auf dem WindowManager_Headless. Jede Struktur wird mit
+ * zufälligen Änderungen gegen eine einfache Referenz geprüft:
+ * - TextBuffer gegen einen ppl7::WideString, auch über Blockgrenzen hinweg
+ * - der absatzweise Umbruch von TextEdit (textChanged) gegen ein frisch mit
+ *   setText gefülltes TextEdit
+ * - die Präfixbreiten von LineInput (updatePrefixWidths) gegen ein frisch mit
+ *   setText gefülltes LineInput
+ *
+ * Aufruf: ppltk-tests
+ * Der Exit-Code ist 0, wenn alle Prüfungen erfolgreich waren.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ppl7.h>
+#include <ppl7-grafix.h>
+#include "ppltk.h"
+
+// Muss zu TEXTBUFFER_CHUNK in src/TextBuffer.cpp passen
+#define CHUNK 4096
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __FILE__, __LINE__)
+
+static bool check(bool ok, const char* expr, const char* file, int line)
+{
+    checks++;
+    if (!ok) {
+        failures++;
+        if (failures <= 20) fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    }
+    return ok;
+}
+
+/*
+ * Einfacher linearer Kongruenzgenerator, damit die Tests auf allen Plattformen
+ * gleich ablaufen
+ */
+static uint32_t random_state = 12345;
+static uint32_t nextRandom()
+{
+    random_state = random_state * 1103515245 + 12345;
+    return (random_state >> 16) & 0x7fff;
+}
+
+static size_t randomSize(size_t max)
+{
+    if (max == 0) return 0;
+    return (((size_t)nextRandom() << 15) | nextRandom()) % max;
+}
+
+static ppl7::WideString makeText(size_t size, int newline_rate)
+{
+    ppl7::WideString text;
+    text.reserve(size);
+    for (size_t i = 0;i < size;i++) {
+        uint32_t r = nextRandom();
+        if (newline_rate > 0 && r % newline_rate == 0) text.append(L'\n');
+        else if (r % 6 == 0) text.append(L' ');
+        else text.append((wchar_t)(L'a' + r % 26));
+    }
+    return text;
+}
+
+/*
+ * Liefert eine Position in der Nähe einer Blockgrenze oder eine zufällige Position
+ */
+static size_t interestingPosition(size_t size)
+{
+    if (nextRandom() % 2 == 0) return randomSize(size + 1);
+    size_t p = (randomSize(size / (CHUNK / 2) + 1)) * (CHUNK / 2);
+    p += nextRandom() % 3;
+    if (p >= 1) p--;
+    if (p > size) p = size;
+    return p;
+}
+
+static void compareTextBuffer(const ppltk::TextBuffer& buffer, const ppl7::WideString& ref)
+{
+    CHECK(buffer.size() == ref.size());
+    CHECK(buffer.isEmpty() == ref.isEmpty());
+    if (!CHECK(buffer.toWideString() == ref)) return;
+    // Stichproben mit operator[] und at, auch an Blockgrenzen
+    for (int i = 0;i < 50 && ref.size() > 0;i++) {
+        size_t p = interestingPosition(ref.size() - 1);
+        CHECK(buffer[p] == ref[p]);
+        ppltk::TextBuffer::const_iterator it = buffer.at(p);
+        CHECK(it.position() == p);
+        CHECK(*it == ref[p]);
+        ++it;
+        if (p + 1 < ref.size()) CHECK(*it == ref[p + 1]);
+        else CHECK(it == buffer.end());
+    }
+    for (int i = 0;i < 10;i++) {
+        size_t p = interestingPosition(ref.size());
+        size_t n = randomSize(2 * CHUNK);
+        CHECK(buffer.mid(p, n) == ref.mid(p, n));
+    }
+    CHECK(buffer.mid(0) == ref);
+    // Einmal komplett durchlaufen
+    size_t p = 0;
+    bool same = true;
+    for (ppltk::TextBuffer::const_iterator it = buffer.begin();it != buffer.end();++it) {
+        if (p >= ref.size() || *it != ref[p] || it.position() != p) {
+            same = false;
+            break;
+        }
+        p++;
+    }
+    CHECK(same && p == ref.size());
+}
+
+static void testTextBuffer()
+{
+    ppltk::TextBuffer buffer;
+    ppl7::WideString ref;
+    compareTextBuffer(buffer, ref);
+    CHECK(buffer.begin() == buffer.end());
+
+    // Einfügen in einen leeren Puffer und Löschen bis er wieder leer ist
+    buffer.insert(0, L"abc");
+    ref = L"abc";
+    compareTextBuffer(buffer, ref);
+    buffer.erase(0, 3);
+    ref.clear();
+    compareTextBuffer(buffer, ref);
+
+    // Ein großer Text wird auf mehrere Blöcke verteilt
+    ref = makeText(5 * CHUNK + 17, 40);
+    buffer.set(ref);
+    compareTextBuffer(buffer, ref);
+
+    for (int step = 0;step < 2000;step++) {
+        uint32_t op = nextRandom() % 10;
+        if (op < 4) {
+            // Kurzer Text, wie beim Tippen
+            size_t p = interestingPosition(ref.size());
+            ppl7::WideString t = makeText(1 + nextRandom() % 8, 10);
+            buffer.insert(p, t);
+            ref = ref.left(p) + t + ref.mid(p);
+        } else if (op < 5) {
+            // Großer Text, der den Block teilen muss
+            size_t p = interestingPosition(ref.size());
+            ppl7::WideString t = makeText(CHUNK / 2 + randomSize(2 * CHUNK), 30);
+            buffer.insert(p, t);
+            ref = ref.left(p) + t + ref.mid(p);
+        } else if (op < 8) {
+            size_t p = interestingPosition(ref.size());
+            size_t n = 1 + nextRandom() % 8;
+            buffer.erase(p, n);
+            if (p < ref.size()) ref = ref.left(p) + ref.mid(p + n);
+        } else if (op < 9) {
+            // Über mehrere Blöcke hinweg löschen
+            size_t p = interestingPosition(ref.size());
+            size_t n = randomSize(3 * CHUNK);
+            buffer.erase(p, n);
+            if (p < ref.size()) ref = ref.left(p) + ref.mid(p + n);
+        } else {
+            // Kopien teilen sich die Blöcke, bis eine davon geändert wird
+            ppltk::TextBuffer copy = buffer;
+            CHECK(copy == buffer);
+            size_t p = interestingPosition(ref.size());
+            copy.insert(p, L"#");
+            CHECK(copy != buffer);
+            compareTextBuffer(buffer, ref);
+            copy.erase(p, 1);
+            CHECK(copy == buffer);
+            buffer = copy;
+        }
+        if (step % 50 == 0 || ref.size() < 100) compareTextBuffer(buffer, ref);
+        else CHECK(buffer.size() == ref.size());
+        // Nicht zu groß werden lassen
+        if (ref.size() > 20 * CHUNK) {
+            buffer.erase(0, 10 * CHUNK);
+            ref = ref.mid(10 * CHUNK);
+        }
+    }
+    compareTextBuffer(buffer, ref);
+    buffer.clear();
+    compareTextBuffer(buffer, ppl7::WideString());
+}
+
+static bool sameImage(const ppl7::grafix::Image& a, const ppl7::grafix::Image& b)
+{
+    if (a.width() != b.width() || a.height() != b.height()) return false;
+    size_t bytes = (size_t)a.width() * a.bytesPerPixel();
+    for (int y = 0;y < a.height();y++) {
+        if (memcmp(a.adr(0, y), b.adr(0, y), bytes) != 0) return false;
+    }
+    return true;
+}
+
+static void sendClick(ppltk::Widget& w, int x, int y)
+{
+    ppltk::MouseEvent ev;
+    ev.p.x = x;
+    ev.p.y = y;
+    ev.buttonMask = (ppltk::MouseState::MouseButton)0;
+    ev.setWidget(&w);
+    w.mouseDownEvent(&ev);
+}
+
+static void sendText(ppltk::Widget& w, const ppl7::WideString& text)
+{
+    ppltk::TextInputEvent ev;
+    ev.text = text;
+    w.textInputEvent(&ev);
+}
+
+static void sendKey(ppltk::Widget& w, int key)
+{
+    ppltk::KeyEvent ev;
+    ev.key = key;
+    ev.modifier = 0;
+    ev.repeat = false;
+    w.keyDownEvent(&ev);
+}
+
+/*
+ * Das inkrementell geänderte Widget a und das frisch gefüllte Widget b werden an
+ * der gleichen Stelle angeklickt und gleich bearbeitet. Stimmt der inkrementelle
+ * Umbruch von a nicht, landet der Cursor an einer anderen Stelle und die Texte
+ * laufen auseinander. Zusätzlich wird a mit einem nie fokussierten Widget c
+ * verglichen, das den gleichen Text neu umbricht.
+ */
+static void testTextEdit()
+{
+    const int width = 600, height = 400;
+    ppltk::TextEdit a(0, 0, width, height);
+    ppltk::TextEdit b(0, 0, width, height);
+    ppl7::grafix::Image img_a, img_b;
+    img_a.create(width, height, ppl7::grafix::RGBFormat::A8R8G8B8);
+    img_b.create(width, height, ppl7::grafix::RGBFormat::A8R8G8B8);
+    a.setText(makeText(120, 25));
+    a.paint(img_a);
+    for (int step = 0;step < 300;step++) {
+        b.setText(a.text());
+        b.paint(img_b);
+        int x = nextRandom() % (width - 30);
+        int y = nextRandom() % (height / 2);
+        sendClick(a, x, y);
+        sendClick(b, x, y);
+        uint32_t op = nextRandom() % 10;
+        if (op < 6 || a.text().size() < 10) {
+            ppl7::WideString t = makeText(1, op == 0 ? 1 : 12);
+            sendText(a, t);
+            sendText(b, t);
+        } else if (op < 9) {
+            sendKey(a, ppltk::KeyEvent::KEY_BACKSPACE);
+            sendKey(b, ppltk::KeyEvent::KEY_BACKSPACE);
+        } else {
+            sendKey(a, ppltk::KeyEvent::KEY_DELETE);
+            sendKey(b, ppltk::KeyEvent::KEY_DELETE);
+        }
+        if (!CHECK(a.text() == b.text())) break;
+        // Der Text soll ohne Scrollbar in das Feld passen
+        if (a.text().size() > 400) a.setText(a.text().left(200));
+        ppltk::TextEdit c(0, 0, width, height);
+        c.setText(a.text());
+        c.paint(img_b);
+        a.paint(img_a);
+        if (!CHECK(sameImage(img_a, img_b))) break;
+    }
+}
+
+static void testLineInput()
+{
+    const int width = 600, height = 30;
+    ppltk::LineInput a(0, 0, width, height);
+    ppltk::LineInput b(0, 0, width, height);
+    ppl7::grafix::Image img_a, img_b;
+    img_a.create(width, height, ppl7::grafix::RGBFormat::A8R8G8B8);
+    img_b.create(width, height, ppl7::grafix::RGBFormat::A8R8G8B8);
+    a.setText(makeText(10, 0));
+    for (int step = 0;step < 500;step++) {
+        b.setText(a.text());
+        int x = nextRandom() % width;
+        sendClick(a, x, height / 2);
+        sendClick(b, x, height / 2);
+        uint32_t op = nextRandom() % 10;
+        if (op < 6 || a.text().size() < 5) {
+            ppl7::WideString t = makeText(1, 0);
+            sendText(a, t);
+            sendText(b, t);
+        } else if (op < 9) {
+            sendKey(a, ppltk::KeyEvent::KEY_BACKSPACE);
+            sendKey(b, ppltk::KeyEvent::KEY_BACKSPACE);
+        } else {
+            sendKey(a, ppltk::KeyEvent::KEY_DELETE);
+            sendKey(b, ppltk::KeyEvent::KEY_DELETE);
+        }
+        if (!CHECK(a.text() == b.text())) break;
+        // Der Text soll ohne horizontales Scrollen in das Feld passen
+        if (a.text().size() > 40) a.setText(a.text().left(20));
+        ppltk::LineInput c(0, 0, width, height, a.text());
+        c.paint(img_b);
+        a.paint(img_a);
+        if (!CHECK(sameImage(img_a, img_b))) break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try {
+        ppl7::grafix::Grafix gfx;
+        ppltk::WindowManager_Headless wm;
+        testTextBuffer();
+        testTextEdit();
+        testLineInput();
+    }
+    catch (ppl7::Exception& e) {
+        e.print();
+        return 1;
+    }
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures > 0 ? 1 : 0;
+}